@@ -0,0 +1,2678 @@
+/*
+** bench.c
+** benchmark the sv5.c image processing kernels on fixed input frames
+** without a webcam or framebuffer attached
+**
+** OPTIMIZE compile using:
+** gcc -O3 -DSV5_NO_MAIN bench.c sv5.c -o bench -lrt -lpthread -lm
+** on beaglebone black (armhf) add -mfpu=neon -mfloat-abi=hard, without
+** them the neon kernels are not built
+**
+** usage: bench [-g] [-H] [-i iterations] [-l lutfile] [-t threads]
+**	       [-s WxH[,WxH...]] [-f text|csv|json]
+**	-g		golden output checks only, exit status 1 if any
+**			kernel differs from the reference kernels
+**	-H		convert3 table in locked huge pages, as sv5 -H
+**	-i iterations	timed runs of every kernel (default 50)
+**	-l lutfile	use an existing yuv2rgb.lut for convert3 instead of
+**			building the table in memory
+**	-t threads	largest HaarDwt2 and lifting thread count to time
+**			and check (default 4)
+**	-s sizes	frame sizes to time the kernels at (default
+**			432x240,640x480,1280x720,1920x1080)
+**	-f format	text tables (default), or one csv line / json object
+**			per kernel and size on stdout with the checks and
+**			progress on stderr
+**
+** every kernel is timed in isolation on a fixed pseudo-random frame.
+** the results are ns/pixel (best and mean run), MB/s of frame traffic
+** for the best run, every frame, luma or plane buffer counted once for
+** each pass that reads or writes it, and, where perf_event_open(2) is
+** allowed, cycles, instructions, cache misses and dTLB misses per frame.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+#include "sv5.h"
+
+/*
+** sv5.c look up table used by convert3() and its loader
+*/
+extern uint16_t *lut_ptr;
+extern int lut_size;
+extern int lut_huge;
+extern char *lut_mode;
+int lut_load(char *path);
+int lut_hugepages(void);
+void lut_report(FILE *fp);
+
+/*
+** sv5.c framebuffer state used by the direct output check
+*/
+extern struct fb_var_screeninfo vinfo;
+extern struct fb_fix_screeninfo finfo;
+extern uint16_t *fbp;
+extern long screensize;
+extern int fb_fd;
+extern int dbuf;
+extern unsigned int fb_back;
+extern int fb_file;
+extern uint16_t *fb_dst;
+
+/*
+** timed kernel runs
+*/
+int iterations = 50;
+
+/*
+** HaarDwt2 thread counts 1, 2, 4 .. max_threads
+*/
+int max_threads = 4;
+
+/*
+** benchmark frame sizes
+*/
+#define MAX_SIZES	16
+char *sizes = "432x240,640x480,1280x720,1920x1080";
+
+/*
+** output format, progress and check messages go to info
+*/
+enum { FMT_TEXT, FMT_CSV, FMT_JSON };
+int format = FMT_TEXT;
+FILE *info = NULL;
+int nresults = 0;
+
+/*
+** one timed kernel at one frame size, perf counters are per frame and
+** -1 where not available
+*/
+struct result {
+	char name[32];
+	int width, height;
+	int bytes;			/*frame traffic per pixel*/
+	double best, mean;		/*ns per frame*/
+	long long perf[NPERF];
+};
+
+/*
+** fixed seed pseudo-random number generator so every run of the
+** benchmark sees the same input frame
+*/
+static uint32_t seed = 0x12345678;
+
+static uint32_t bench_rand(void){
+
+	seed = seed*1664525 + 1013904223;
+	return(seed >> 8);
+
+}/*eo bench_rand*/
+
+/*
+** elapsed nanoseconds between two CLOCK_MONOTONIC samples
+*/
+static double ns_diff(struct timespec *a, struct timespec *b){
+
+	return((b->tv_sec - a->tv_sec)*1000000000.0 + (b->tv_nsec - a->tv_nsec));
+
+}/*eo ns_diff*/
+
+/*
+** build the 32 MB yuv2rgb look up table in memory the same way lut.c does
+*/
+static uint16_t *build_lut(void){
+
+	uint16_t *lut = malloc(lut_size);
+	int y=0,u=0,v=0;
+
+	if(lut == NULL)
+		return(NULL);
+
+	for(y=0; y<256; y++)
+		for(u=0; u<256; u++)
+			for(v=0; v<256; v++)
+				lut[(y*256*256)+(u*256)+v] = yuv422_to_rgb565(y,u,v);
+
+	return(lut);
+
+}/*eo build_lut*/
+
+/*
+** check_pixels
+** compare a yuv422 to rgb565 pixel kernel against yuv422_to_rgb565() for
+** every possible Y,U,V triple. each block holds all U,V pairs for one Y1
+** with Y0 = 255-Y1, so both pixels of a macropixel are exercised.
+** returns the number of mismatches.
+*/
+static long check_pixels(char *name, 
+			 void (*fn)(uint8_t *yuvptr, uint16_t *outptr, int n)){
+
+	static uint8_t yuyv[256*256*4];
+	static uint16_t out[256*256*2];
+	uint8_t *p=NULL;
+	long bad=0;
+	int y=0,u=0,v=0,i=0,Y=0;
+
+	for(y=0; y<256; y++){
+
+		/*
+		** macropixels Y1,V0,Y0,U0
+		*/
+		p = yuyv;
+		for(u=0; u<256; u++){
+			for(v=0; v<256; v++){
+				*p++ = y;
+				*p++ = v;
+				*p++ = 255-y;
+				*p++ = u;
+			}/*eo for*/
+		}/*eo for*/
+
+		fn(yuyv, out, 256*256*2);
+
+		/*
+		** pixel 0 of a macropixel is Y0, pixel 1 is Y1
+		*/
+		for(i=0; i<256*256*2; i++){
+			Y = (i & 1) ? y : 255-y;
+			u = (i/2) / 256;
+			v = (i/2) % 256;
+			if(out[i] != yuv422_to_rgb565(Y,u,v)){
+				if(bad == 0)
+					fprintf(info, "%s: first mismatch at Y=%d U=%d V=%d "
+						"%04x != %04x\n", name, Y, u, v, out[i],
+						yuv422_to_rgb565(Y,u,v));
+				bad++;
+			}/*eo if*/
+		}/*eo for*/
+
+	}/*eo for*/
+
+	return(bad);
+
+}/*eo check_pixels*/
+
+/*
+** kernels under test
+*/
+static uint8_t *yuyv=NULL, *rgb565=NULL, *dwt=NULL;
+
+static void run_convert2(void){ convert2(yuyv, rgb565); }
+static void run_convert3(void){ convert3(yuyv, rgb565, lut_ptr); }
+static void run_convert4(void){ convert4(yuyv, rgb565); }
+static void run_convert5(void){ convert5(yuyv, rgb565); }
+static void run_convert3_haar(void){
+	convert3(yuyv, rgb565, lut_ptr);
+	HaarDwt((uint16_t *)rgb565, (uint16_t *)dwt);
+}
+static void run_convert5_haar(void){
+	convert5(yuyv, rgb565);
+	HaarDwt((uint16_t *)rgb565, (uint16_t *)dwt);
+}
+static void run_haar_yuyv(void){ HaarDwtYuyv(yuyv, (uint16_t *)dwt); }
+static void run_convert5_haar2(void){
+	convert5(yuyv, rgb565);
+	HaarDwt2((uint16_t *)rgb565, (uint16_t *)dwt, cap_geo.width, 
+		 cap_geo.height, cap_geo.width);
+}
+static void run_haar(void){ HaarDwt((uint16_t *)rgb565, (uint16_t *)dwt); }
+static void run_display(void){ display_LCD4(fbp, dwt); }
+static void run_luma(void){ LumaExtract(yuyv, rgb565); }
+static void run_haar_gray(void){ HaarDwtGray(rgb565, dwt); }
+static void run_luma_haar_gray(void){
+	LumaExtract(yuyv, rgb565);
+	HaarDwtGray(rgb565, dwt);
+}
+static void run_display_gray(void){ display_gray(fbp, dwt); }
+static int16_t *planes=NULL;
+static void run_lift(void){
+
+	int n = cap_geo.width*cap_geo.height, c=0;
+
+	Rgb565ToPlanes((uint16_t *)rgb565, planes, cap_geo.width, 
+		       cap_geo.height);
+	for(c=0; c<3; c++)
+		HaarLift(planes + c*n, cap_geo.width, cap_geo.height, 
+			 cap_geo.width, 3);
+}
+static void run_lift_unlift(void){
+
+	int n = cap_geo.width*cap_geo.height, c=0;
+
+	Rgb565ToPlanes((uint16_t *)rgb565, planes, cap_geo.width, 
+		       cap_geo.height);
+	for(c=0; c<3; c++){
+		HaarLift2(planes + c*n, cap_geo.width, cap_geo.height, 
+			  cap_geo.width, 3);
+		HaarUnlift2(planes + c*n, cap_geo.width, cap_geo.height, 
+			    cap_geo.width, 3);
+	}/*eo for*/
+	PlanesToRgb565(planes, (uint16_t *)rgb565, cap_geo.width, 
+		       cap_geo.height);
+}
+static void run_denoise(void){
+	DenoiseRgb565((uint16_t *)rgb565, (uint16_t *)rgb565, planes, 
+		      cap_geo.width, cap_geo.height, 0, 1);
+}
+
+/*
+** input and checked output of a kernel
+** rgb565 outputs are checked against convert2(), dwt outputs against
+** convert2() followed by HaarDwt() and the framebuffer against the dwt
+** frame that was displayed, round trips (and the denoise at threshold
+** 0, which shrinks nothing) against their input frame.
+** 8 bit luma and int16 plane kernels are checked by check_golden() only.
+** bytes is the frame traffic per pixel: yuyv and rgb565 frames are 2 
+** bytes, luma 1 and the three int16 planes 6, a lifting pass reads and
+** writes the planes once, the round trips also read them back.
+*/
+enum { IN_YUYV, IN_RGB565, IN_DWT };
+enum { OUT_RGB565, OUT_DWT, OUT_FB, OUT_GRAY, OUT_PLANES };
+
+struct kernel {
+	char *name;
+	void (*run)(void);
+	char *isa;		/*convert5 kernel to select first*/
+	int in, out;
+	int bytes;
+};
+
+static struct kernel kernels[] = {
+	{ "convert2", run_convert2, NULL, IN_YUYV, OUT_RGB565, 4 },
+	{ "convert3", run_convert3, NULL, IN_YUYV, OUT_RGB565, 4 },
+	{ "convert4", run_convert4, NULL, IN_YUYV, OUT_RGB565, 4 },
+	{ "convert5-scalar", run_convert5, "scalar", IN_YUYV, OUT_RGB565, 4 },
+	{ "convert5-sse2", run_convert5, "sse2", IN_YUYV, OUT_RGB565, 4 },
+	{ "convert5-avx2", run_convert5, "avx2", IN_YUYV, OUT_RGB565, 4 },
+	{ "convert5-neon", run_convert5, "neon", IN_YUYV, OUT_RGB565, 4 },
+	{ "HaarDwt", run_haar, NULL, IN_RGB565, OUT_DWT, 4 },
+	{ "display_LCD4", run_display, NULL, IN_DWT, OUT_FB, 4 },
+	{ "convert3+HaarDwt", run_convert3_haar, NULL, IN_YUYV, OUT_DWT, 8 },
+	{ "convert5+HaarDwt", run_convert5_haar, NULL, IN_YUYV, OUT_DWT, 8 },
+	{ "HaarDwtYuyv", run_haar_yuyv, NULL, IN_YUYV, OUT_DWT, 4 },
+	{ "convert5+HaarDwt2", run_convert5_haar2, NULL, IN_YUYV, OUT_DWT, 8 },
+	{ "LumaExtract", run_luma, NULL, IN_YUYV, OUT_GRAY, 3 },
+	{ "HaarDwtGray", run_haar_gray, NULL, IN_RGB565, OUT_GRAY, 2 },
+	{ "luma+HaarDwtGray", run_luma_haar_gray, NULL, IN_YUYV, OUT_GRAY, 5 },
+	{ "display_gray", run_display_gray, NULL, IN_DWT, OUT_GRAY, 3 },
+	{ "planes+HaarLift3", run_lift, NULL, IN_RGB565, OUT_PLANES, 20 },
+	{ "lift3+unlift3", run_lift_unlift, NULL, IN_RGB565, OUT_RGB565, 40 },
+	{ "DenoiseRgb565", run_denoise, NULL, IN_RGB565, OUT_RGB565, 16 },
+};
+
+#define NKERNELS	(int)(sizeof(kernels)/sizeof(kernels[0]))
+
+/*
+** make the kernel runnable, returns -1 if the cpu lacks its isa
+*/
+static int kernel_select(struct kernel *k){
+
+	if(k->isa)
+		return(simd_select(k->isa));
+
+	return(0);
+
+}/*eo kernel_select*/
+
+/*
+** fake framebuffers
+** open_fb() maps a file backed framebuffer of width x height pixels 
+** with line byte lines (0 for packed ones), two pages of height lines 
+** with dbuf, and shows its xres x yres area (0 for all of it) at 
+** xoffset, yoffset. the sv5.c framebuffer state it replaces is kept in
+** saved and put back by close_fb(), or by open_fb() when it fails.
+*/
+struct fake_fb {
+	int width, height, line;
+	int xres, yres, xoffset, yoffset;
+	int dbuf;
+	char path[sizeof("/tmp/sv5fbXXXXXX")];
+	struct {
+		struct fb_var_screeninfo vinfo;
+		struct fb_fix_screeninfo finfo;
+		struct geometry geo;
+		uint16_t *fbp, *dst;
+		long screensize;
+		int fd, file, dbuf;
+		unsigned int back;
+	} saved;
+};
+
+/*
+** 480x272 visible at (16,272) of 496x544, 1024 byte lines
+*/
+static const struct fake_fb hvga_fb = {
+	.width = 496, .height = 544, .line = 1024, .xres = HVGA_WIDTH, 
+	.yres = HVGA_HEIGHT, .xoffset = 16, .yoffset = HVGA_HEIGHT
+};
+
+static void close_fb(struct fake_fb *fb){
+
+	if(fbp != NULL)
+		munmap(fbp, screensize);
+	if(fb_fd >= 0)
+		close(fb_fd);
+	unlink(fb->path);
+	vinfo = fb->saved.vinfo;
+	finfo = fb->saved.finfo;
+	fb_geo = fb->saved.geo;
+	fbp = fb->saved.fbp;
+	fb_dst = fb->saved.dst;
+	screensize = fb->saved.screensize;
+	fb_fd = fb->saved.fd;
+	fb_file = fb->saved.file;
+	dbuf = fb->saved.dbuf;
+	fb_back = fb->saved.back;
+
+}/*eo close_fb*/
+
+static int open_fb(struct fake_fb *fb){
+
+	char spec[64];
+	int fd=0;
+
+	strcpy(fb->path, "/tmp/sv5fbXXXXXX");
+	if((fd = mkstemp(fb->path)) < 0){
+		perror("mkstemp");
+		return(-1);
+	}/*eo if*/
+	close(fd);
+
+	fb->saved.vinfo = vinfo;
+	fb->saved.finfo = finfo;
+	fb->saved.geo = fb_geo;
+	fb->saved.fbp = fbp;
+	fb->saved.dst = fb_dst;
+	fb->saved.screensize = screensize;
+	fb->saved.fd = fb_fd;
+	fb->saved.file = fb_file;
+	fb->saved.dbuf = dbuf;
+	fb->saved.back = fb_back;
+	fbp = NULL;
+	fb_fd = -1;
+	dbuf = fb->dbuf;
+
+	snprintf(spec, sizeof(spec), "%s,%d,%d,%d", fb->path, fb->width, 
+		 fb->height, fb->line);
+	if(fb_open_file(spec) < 0){
+		close_fb(fb);
+		return(-1);
+	}/*eo if*/
+	if(fb->xres)
+		vinfo.xres = fb->xres;
+	if(fb->yres)
+		vinfo.yres = fb->yres;
+	vinfo.xoffset = fb->xoffset;
+	vinfo.yoffset = fb->yoffset;
+	fb_back = dbuf ? vinfo.yres : 0;
+	if(fb_geometry() < 0){
+		close_fb(fb);
+		return(-1);
+	}/*eo if*/
+
+	return(0);
+
+}/*eo open_fb*/
+
+/*
+** check_direct
+** run the strided haar dwt kernels into a file backed fake framebuffer
+** with a padded line length and a panning offset, and compare the frame
+** with the HaarDwt() reference. every pixel outside the frame must keep
+** its sentinel value. returns the number of bad pixels.
+*/
+static long check_direct(uint8_t *yuyv, uint8_t *rgb565, uint8_t *ref_dwt){
+
+	struct fake_fb fb = hvga_fb;
+	uint16_t *dst=NULL, *p=NULL, *ref=(uint16_t *)ref_dwt;
+	long bad=0, n=0;
+	int pass=0, x=0, y=0, x0=0, y0=0;
+
+	if(open_fb(&fb) < 0)
+		return(-1);
+	dst = fb_origin(fbp, WQVGA_WIDTH, WQVGA_HEIGHT);
+	x0 = vinfo.xoffset + (HVGA_WIDTH-WQVGA_WIDTH)/2;
+	y0 = vinfo.yoffset + (HVGA_HEIGHT-WQVGA_HEIGHT)/2;
+
+	for(pass=0; pass<2; pass++){
+
+		for(p=fbp; p<fbp+screensize/2; p++)
+			*p = 0xaaaa;
+
+		if(pass == 0)
+			HaarDwtYuyvStride(yuyv, dst, finfo.line_length/2);
+		else
+			HaarDwtStride((uint16_t *)rgb565, dst, finfo.line_length/2);
+
+		n = 0;
+		for(y=0; y<(int)vinfo.yres_virtual; y++){
+			p = (uint16_t *)((uint8_t *)fbp + y*finfo.line_length);
+			for(x=0; x<(int)(finfo.line_length/2); x++){
+				if(y >= y0 && y < y0+WQVGA_HEIGHT && 
+				   x >= x0 && x < x0+WQVGA_WIDTH){
+					if(p[x] != ref[(y-y0)*WQVGA_WIDTH + (x-x0)])
+						n++;
+				}else if(p[x] != 0xaaaa){
+					n++;
+				}/*eo if*/
+			}/*eo for*/
+		}/*eo for*/
+		fprintf(info, "%-18s %ld bad pixels in a fake framebuffer\n", 
+			pass == 0 ? "HaarDwtYuyvStride" : "HaarDwtStride", n);
+		bad += n;
+
+	}/*eo for*/
+
+	close_fb(&fb);
+
+	return(bad);
+
+}/*eo check_direct*/
+
+/*
+** check_flip
+** double buffered display_LCD4 into a two page fake framebuffer: every
+** frame must land in the hidden page, leave the shown page alone, and
+** fb_flip() must show it and hand the other page back. returns the
+** number of bad frames.
+*/
+static long check_flip(uint8_t *ref_dwt){
+
+	struct fake_fb fb = { .width = HVGA_WIDTH, .height = HVGA_HEIGHT, 
+			      .dbuf = 1 };
+	uint16_t *p=NULL, *row=NULL;
+	long bad=0, n=0;
+	int i=0, y=0, page=0, shown=0;
+
+	if(open_fb(&fb) < 0)
+		return(-1);
+	page = HVGA_HEIGHT*finfo.line_length/2;
+
+	for(i=0; i<4; i++){
+
+		for(p=fbp; p<fbp+screensize/2; p++)
+			*p = 0xaaaa;
+		shown = vinfo.yoffset;
+		display_LCD4(fbp, ref_dwt);
+
+		/*
+		** the shown page is untouched, the hidden one has the frame
+		*/
+		n = 0;
+		for(p=fbp + (shown ? page : 0); p<fbp + (shown ? 2*page : page); 
+		    p++)
+			n += *p != 0xaaaa;
+		row = fb_origin(fbp, WQVGA_WIDTH, WQVGA_HEIGHT);
+		for(y=0; y<WQVGA_HEIGHT; y++){
+			n += memcmp(row, ref_dwt + y*WQVGA_WIDTH*2, 
+				    WQVGA_WIDTH*2) != 0;
+			row += finfo.line_length/2;
+		}/*eo for*/
+		if(fb_back == (unsigned)shown)
+			n++;
+
+		fb_flip();
+		if(vinfo.yoffset == (unsigned)shown || fb_back != (unsigned)shown)
+			n++;
+		if(n){
+			fprintf(info, "%-18s frame %d: %ld bad pixels or page "
+				"offsets\n", "fb_flip", i, n);
+			bad++;
+		}/*eo if*/
+
+	}/*eo for*/
+	fprintf(info, "%-18s %ld of %d double buffered frames bad\n", 
+		"fb_flip", bad, i);
+
+	/*
+	** a new layout clears the page being drawn, not the one shown
+	*/
+	for(p=fbp; p<fbp+screensize/2; p++)
+		*p = 0xaaaa;
+	shown = vinfo.yoffset;
+	clear_fb_page(fbp, GRAY);
+	n = 0;
+	for(i=0; i<2*page; i++)
+		n += fbp[i] != ((i >= page) == (shown == 0) ? GRAY : 0xaaaa);
+	fprintf(info, "%-18s %ld bad pixels clearing the hidden page\n",
+		"clear_fb_page", n);
+	bad += n;
+
+	close_fb(&fb);
+
+	return(bad);
+
+}/*eo check_flip*/
+
+/*
+** check_blit
+** blit_rgb565 with every row copy into a fake framebuffer with a 1024
+** byte line length and panning offsets: frames smaller than, equal to
+** and larger than the visible 480x272 area, padded source lines, odd
+** widths and destination columns for the streaming head and tail, and
+** the repeated row of the colour bars. the frame must be centred and
+** clipped with everything around it untouched. returns the number of
+** bad pixels.
+*/
+static char *blit_modes[] = { "memcpy", "stream" };
+#define NBLIT_MODES	(sizeof(blit_modes)/sizeof(blit_modes[0]))
+
+static long check_blit(void){
+
+	static const int sizes[][2] = {
+		{ WQVGA_WIDTH, WQVGA_HEIGHT }, { HVGA_WIDTH, HVGA_HEIGHT }, 
+		{ VGA_WIDTH, VGA_HEIGHT }, { 251, 97 }, { 7, 3 }, { 1, 1 }
+	};
+	struct fake_fb fb = hvga_fb;
+	uint16_t *src=NULL, *p=NULL, expect=0;
+	long bad=0, n=0;
+	int m=0, i=0, x=0, y=0, x0=0, y0=0, cw=0, ch=0, sw=0, pass=0;
+	int w=0, h=0, stride=0;
+
+	src = malloc((VGA_WIDTH + 32)*VGA_HEIGHT*sizeof(uint16_t));
+	if(src == NULL || open_fb(&fb) < 0){
+		free(src);
+		return(-1);
+	}/*eo if*/
+	for(i=0; i<(VGA_WIDTH + 32)*VGA_HEIGHT; i++)
+		src[i] = bench_rand();
+
+	for(m=0; m<(int)NBLIT_MODES; m++){
+
+		if(blit_select(blit_modes[m]) < 0)
+			continue;
+
+		n = 0;
+		for(i=0; i<(int)(sizeof(sizes)/sizeof(sizes[0])); i++){
+			for(pass=0; pass<2; pass++){
+
+				/*
+				** padded source lines, then one repeated row
+				*/
+				w = sizes[i][0];
+				h = sizes[i][1];
+				stride = pass == 0 ? (w + 13)*2 : 0;
+				for(p=fbp; p<fbp+screensize/2; p++)
+					*p = 0xaaaa;
+				blit_rgb565(fbp, NULL, src, w, h, stride);
+
+				cw = w < HVGA_WIDTH ? w : HVGA_WIDTH;
+				ch = h < HVGA_HEIGHT ? h : HVGA_HEIGHT;
+				x0 = vinfo.xoffset + (HVGA_WIDTH - cw)/2;
+				y0 = vinfo.yoffset + (HVGA_HEIGHT - ch)/2;
+				sw = stride/2;
+				for(y=0; y<(int)vinfo.yres_virtual; y++){
+					p = (uint16_t *)((uint8_t *)fbp + 
+							 y*finfo.line_length);
+					for(x=0; x<(int)(finfo.line_length/2); x++){
+						expect = 0xaaaa;
+						if(y >= y0 && y < y0+ch && 
+						   x >= x0 && x < x0+cw)
+							expect = src[(y - y0 + (h - ch)/2)*sw
+								     + x - x0 + (w - cw)/2];
+						n += p[x] != expect;
+					}/*eo for*/
+				}/*eo for*/
+
+			}/*eo for*/
+		}/*eo for*/
+		fprintf(info, "%-18s %ld bad pixels in a fake framebuffer\n", 
+			blit_modes[m], n);
+		bad += n;
+
+	}/*eo for*/
+
+	/*
+	** colour bars, eight equal bands from white to black
+	*/
+	for(p=fbp; p<fbp+screensize/2; p++)
+		*p = 0xaaaa;
+	RGBColorBars_LCD4(fbp);
+	p = fb_origin(fbp, WQVGA_WIDTH, WQVGA_HEIGHT);
+	n = 0;
+	for(x=0; x<WQVGA_WIDTH; x++)
+		n += p[(WQVGA_HEIGHT-1)*finfo.line_length/2 + x] != 
+			(x < WQVGA_WIDTH/8 ? WHITE : x >= 7*WQVGA_WIDTH/8 ? 
+			 BLACK : p[x]);
+	n += p[0] != WHITE || p[WQVGA_WIDTH/8] != YELLOW || 
+		p[-1] != 0xaaaa || p[WQVGA_WIDTH] != 0xaaaa;
+	fprintf(info, "%-18s %ld bad pixels in a fake framebuffer\n", 
+		"RGBColorBars_LCD4", n);
+	bad += n;
+
+	init_blit();
+	free(src);
+	close_fb(&fb);
+
+	return(bad);
+
+}/*eo check_blit*/
+
+/*
+** emit
+** print one result in the selected format
+*/
+static void emit(struct result *r){
+
+	int npixels = r->width*r->height;
+	double mbs = (double)r->bytes*npixels/r->best*1000.0;
+	int i=0;
+
+	switch(format){
+	case FMT_CSV:
+		if(nresults == 0){
+			printf("kernel,width,height,iterations,best_ns_per_pixel,"
+			       "mean_ns_per_pixel,mb_per_s");
+			for(i=0; i<NPERF; i++)
+				printf(",%s", perf_name[i]);
+			printf("\n");
+		}/*eo if*/
+		printf("%s,%d,%d,%d,%.4f,%.4f,%.1f", r->name, r->width, 
+		       r->height, iterations, r->best/npixels, r->mean/npixels, 
+		       mbs);
+		for(i=0; i<NPERF; i++){
+			if(r->perf[i] < 0) printf(",");
+			else printf(",%lld", r->perf[i]);
+		}/*eo for*/
+		printf("\n");
+		break;
+	case FMT_JSON:
+		printf("%s{\"kernel\": \"%s\", \"width\": %d, \"height\": %d, "
+		       "\"iterations\": %d, \"best_ns_per_pixel\": %.4f, "
+		       "\"mean_ns_per_pixel\": %.4f, \"mb_per_s\": %.1f", 
+		       nresults ? ",\n " : "[", r->name, r->width, r->height, 
+		       iterations, r->best/npixels, r->mean/npixels, mbs);
+		for(i=0; i<NPERF; i++){
+			if(r->perf[i] < 0) printf(", \"%s\": null", perf_name[i]);
+			else printf(", \"%s\": %lld", perf_name[i], r->perf[i]);
+		}/*eo for*/
+		printf("}");
+		break;
+	default:
+		printf("%-18s %10.2f %10.2f %9.0f", r->name, r->best/npixels, 
+		       r->mean/npixels, mbs);
+		for(i=0; i<NPERF; i++){
+			if(r->perf[i] < 0) 
+				printf(" %9s", "-");
+			else if(i == PERF_CYCLES || i == PERF_INSTRUCTIONS)
+				printf(" %9.2f", (double)r->perf[i]/npixels);
+			else
+				printf(" %9lld", r->perf[i]);
+		}/*eo for*/
+		printf("\n");
+		break;
+	}/*eo switch*/
+	nresults++;
+
+}/*eo emit*/
+
+/*
+** bench_haar2
+** time HaarDwt2 on a width x height rgb565 frame for every simd kernel
+** and thread count. every result must match the scalar single thread
+** frame, and that one must match HaarDwt(). returns the number of
+** mismatching runs.
+*/
+static char *isas[] = { "scalar", "sse2", "avx2", "neon" };
+
+static long bench_haar2(int width, int height){
+
+	uint16_t *in=NULL, *out=NULL, *ref=NULL;
+	struct timespec t0, t1;
+	struct result r;
+	double t=0, best=0, base=0, scalar=0;
+	long bad=0;
+	int i=0, j=0, n=0, size=width*height*2;
+
+	in = malloc(size);
+	out = malloc(size);
+	ref = malloc(size);
+	if(in == NULL || out == NULL || ref == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	for(i=0; i<width*height; i++)
+		in[i] = bench_rand();
+
+	simd_select("scalar");
+	HaarDwt2(in, ref, width, height, width);
+	cap_geo.width = width;
+	cap_geo.height = height;
+	HaarDwt(in, out);
+	cap_geo.width = WQVGA_WIDTH;
+	cap_geo.height = WQVGA_HEIGHT;
+	if(memcmp(out, ref, size) != 0){
+		fprintf(info, "HaarDwt2 scalar differs from HaarDwt at %dx%d\n", 
+			width, height);
+		bad++;
+	}/*eo if*/
+
+	for(i=0; i<(int)(sizeof(isas)/sizeof(isas[0])); i++){
+
+		if(simd_select(isas[i]) < 0)
+			continue;
+
+		for(n=1; n<=max_threads; n*=2){
+
+			if(pool_init(n) < 0){
+				pool_shutdown();
+				break;
+			}/*eo if*/
+
+			memset(out, 0, size);
+			HaarDwt2(in, out, width, height, width);
+			if(memcmp(out, ref, size) != 0){
+				fprintf(info, "HaarDwt2 %s %d threads differs at %dx%d\n",
+					isas[i], n, width, height);
+				bad++;
+			}/*eo if*/
+
+			for(j=0; j<iterations; j++){
+				clock_gettime(CLOCK_MONOTONIC, &t0);
+				HaarDwt2(in, out, width, height, width);
+				clock_gettime(CLOCK_MONOTONIC, &t1);
+				t = ns_diff(&t0, &t1);
+				if(j == 0 || t < best) best = t;
+			}/*eo for*/
+			pool_shutdown();
+
+			if(n == 1) base = best;
+			if(i == 0 && n == 1) scalar = best;
+			fprintf(info, "%4dx%-4d %-8s %3d %10.3f %8.2f %8.2f\n", 
+				width, height, isas[i], n, best/1000000, base/best, 
+				scalar/best);
+
+			/*
+			** machine readable output gets a record per run
+			*/
+			if(format != FMT_TEXT){
+				snprintf(r.name, sizeof(r.name), "HaarDwt2-%s-%dt", 
+					 isas[i], n);
+				r.width = width;
+				r.height = height;
+				r.bytes = 4;
+				r.best = r.mean = best;
+				for(j=0; j<NPERF; j++)
+					r.perf[j] = -1;
+				emit(&r);
+			}/*eo if*/
+
+		}/*eo for*/
+
+	}/*eo for*/
+
+	free(in);
+	free(out);
+	free(ref);
+
+	return(bad);
+
+}/*eo bench_haar2*/
+
+/*
+** bench_blit
+** time full screen blit_rgb565 copies into the open framebuffer with
+** every row copy, MB/s written into the framebuffer
+*/
+static void bench_blit(char *target){
+
+	uint16_t *frame=NULL;
+	struct timespec t0, t1;
+	struct result r;
+	double ns=0, best=0;
+	int m=0, i=0, j=0, width=vinfo.xres, height=vinfo.yres;
+
+	frame = malloc(width*height*sizeof(uint16_t));
+	if(frame == NULL){
+		fprintf(info, "malloc failed\n");
+		return;
+	}/*eo if*/
+	for(i=0; i<width*height; i++)
+		frame[i] = bench_rand();
+
+	for(m=0; m<(int)NBLIT_MODES; m++){
+
+		if(blit_select(blit_modes[m]) < 0)
+			continue;
+		for(j=0; j<=iterations; j++){
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			blit_rgb565(fbp, NULL, frame, width, height, width*2);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			ns = ns_diff(&t0, &t1);
+			if(j == 1 || (j > 1 && ns < best))
+				best = ns;
+		}/*eo for*/
+		fprintf(info, "%-9s %-8s %4dx%-4d %10.3f %10.1f\n", target, 
+			blit_modes[m], width, height, best/1000000, 
+			2000.0*width*height/best);
+
+		if(format != FMT_TEXT){
+			snprintf(r.name, sizeof(r.name), "blit-%s-%s", target, 
+				 blit_modes[m]);
+			r.width = width;
+			r.height = height;
+			r.bytes = 2;
+			r.best = r.mean = best;
+			for(j=0; j<NPERF; j++)
+				r.perf[j] = -1;
+			emit(&r);
+		}/*eo if*/
+
+	}/*eo for*/
+	init_blit();
+	free(frame);
+
+}/*eo bench_blit*/
+
+/*
+** bench_lift
+** time the three plane, three level lifting round trip of a width x 
+** height rgb565 frame for every thread count: Rgb565ToPlanes and 
+** HaarLift2 forward, HaarUnlift2 and PlanesToRgb565 back, against the
+** LATENCY_BUDGET_MS frame budget. the frame must come back unchanged.
+** returns the number of bad runs.
+*/
+static long bench_lift(int width, int height){
+
+	uint16_t *in=NULL, *out=NULL;
+	int16_t *p=NULL;
+	struct timespec t0, t1, t2;
+	struct result r;
+	double fwd=0, inv=0, best_fwd=0, best_inv=0;
+	long bad=0;
+	int i=0, j=0, n=0, c=0, npix=width*height;
+
+	in = malloc(npix*sizeof(uint16_t));
+	out = malloc(npix*sizeof(uint16_t));
+	p = malloc(3*npix*sizeof(int16_t));
+	if(in == NULL || out == NULL || p == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	for(i=0; i<npix; i++)
+		in[i] = bench_rand();
+
+	for(n=1; n<=max_threads; n*=2){
+
+		if(pool_init(n) < 0){
+			pool_shutdown();
+			break;
+		}/*eo if*/
+
+		for(j=0; j<=iterations; j++){
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			Rgb565ToPlanes(in, p, width, height);
+			for(c=0; c<3; c++)
+				HaarLift2(p + c*npix, width, height, width, 3);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			for(c=0; c<3; c++)
+				HaarUnlift2(p + c*npix, width, height, width, 3);
+			PlanesToRgb565(p, out, width, height);
+			clock_gettime(CLOCK_MONOTONIC, &t2);
+			fwd = ns_diff(&t0, &t1);
+			inv = ns_diff(&t1, &t2);
+
+			/*
+			** the first run warms up the pool and the planes
+			*/
+			if(j == 1 || (j > 1 && fwd + inv < best_fwd + best_inv)){
+				best_fwd = fwd;
+				best_inv = inv;
+			}/*eo if*/
+		}/*eo for*/
+		pool_shutdown();
+
+		if(memcmp(in, out, npix*sizeof(uint16_t)) != 0){
+			fprintf(info, "lift round trip %d threads differs at "
+				"%dx%d\n", n, width, height);
+			bad++;
+		}/*eo if*/
+		fprintf(info, "%4dx%-4d %3d %10.3f %10.3f %10.3f %7.1f%%\n", 
+			width, height, n, best_fwd/1000000, best_inv/1000000,
+			(best_fwd + best_inv)/1000000, 
+			(best_fwd + best_inv)/(LATENCY_BUDGET_MS*10000.0));
+
+		if(format != FMT_TEXT){
+			snprintf(r.name, sizeof(r.name), "lift3+unlift3-%dt", n);
+			r.width = width;
+			r.height = height;
+			r.bytes = 40;
+			r.best = r.mean = best_fwd + best_inv;
+			for(j=0; j<NPERF; j++)
+				r.perf[j] = -1;
+			emit(&r);
+		}/*eo if*/
+
+	}/*eo for*/
+
+	free(in);
+	free(out);
+	free(p);
+
+	return(bad);
+
+}/*eo bench_lift*/
+
+/*
+** golden scaler
+** the same centre aligned 16.16 mapping as scale_init() written out per
+** pixel, each channel blended on its own with 5 bit weights, the rows
+** first and then the columns
+*/
+static void golden_index(int i, int n, int src, int mode, int *idx, 
+			 int *w){
+
+	long long pos = ((long long)(2*i + 1)*src*65536)/(2*n) - 32768;
+
+	*w = 0;
+	if(mode == SCALE_NEAREST){
+		*idx = ((long long)(2*i + 1)*src)/(2*n);
+		return;
+	}/*eo if*/
+	if(pos < 0) pos = 0;
+	*idx = pos/65536;
+	*w = (pos % 65536)/2048;
+	if(*idx > src - 2){
+		*idx = src - 2;
+		*w = 32;
+	}/*eo if*/
+
+}/*eo golden_index*/
+
+static uint16_t golden_lerp(uint16_t a, uint16_t b, int w){
+
+	int r = ((a >> 11)*(32 - w) + (b >> 11)*w)/32;
+	int g = (((a >> 5) & 63)*(32 - w) + ((b >> 5) & 63)*w)/32;
+	int bl = ((a & 31)*(32 - w) + (b & 31)*w)/32;
+
+	return(r << 11 | g << 5 | bl);
+
+}/*eo golden_lerp*/
+
+static uint16_t golden_scale(const uint16_t *src, int stride, int sw, 
+			     int sh, int dw, int dh, int mode, int x, int y){
+
+	int xi=0, xw=0, yi=0, yw=0;
+	const uint16_t *r0=NULL, *r1=NULL;
+
+	golden_index(x, dw, sw, mode, &xi, &xw);
+	golden_index(y, dh, sh, mode, &yi, &yw);
+	r0 = src + yi*stride;
+	if(mode == SCALE_NEAREST)
+		return(r0[xi]);
+	r1 = r0 + stride;
+
+	return(golden_lerp(golden_lerp(r0[xi], r0[xi + 1], xw), 
+			   golden_lerp(r1[xi], r1[xi + 1], xw), yw));
+
+}/*eo golden_scale*/
+
+/*
+** check_scale
+** scale_rgb565 up and down, to odd and unchanged sizes, nearest and 
+** bilinear, with every simd kernel and pool thread count into a fake
+** framebuffer with panning offsets and a padded line length, against 
+** golden_scale. the scaled frame must be centred with everything around
+** it untouched and the unchanged size must give back the source. 
+** returns the number of bad pixels.
+*/
+static long check_scale(void){
+
+	static const int sizes[][4] = {
+		{ WQVGA_WIDTH, WQVGA_HEIGHT, 1000, 555 },
+		{ WQVGA_WIDTH, WQVGA_HEIGHT, HVGA_WIDTH, 266 },
+		{ WQVGA_WIDTH, WQVGA_HEIGHT, WQVGA_WIDTH, WQVGA_HEIGHT },
+		{ VGA_WIDTH, VGA_HEIGHT, 301, 226 },
+		{ HD_WIDTH, HD_HEIGHT, 17, 9 },
+		{ 6, 4, 999, 600 },
+		{ 2, 2, 3, 1000 - 400 }
+	};
+	struct fake_fb fb = {	/*1000x600 at (24,12), 2112 byte lines*/
+		.width = 1040, .height = 620, .line = 2112, .xres = 1000, 
+		.yres = 600, .xoffset = 24, .yoffset = 12
+	};
+	char name[32];
+	struct scaler sc;
+	uint16_t *src=NULL, *p=NULL, expect=0;
+	long bad=0, n=0;
+	int i=0, k=0, t=0, mode=0, x=0, y=0, x0=0, y0=0, stride=0;
+
+	stride = HD_WIDTH + 24;
+	src = malloc(stride*HD_HEIGHT*sizeof(uint16_t));
+	if(src == NULL || open_fb(&fb) < 0){
+		free(src);
+		return(-1);
+	}/*eo if*/
+	for(i=0; i<stride*HD_HEIGHT; i++)
+		src[i] = bench_rand();
+
+	for(k=0; k<(int)(sizeof(isas)/sizeof(isas[0])); k++){
+	for(mode=SCALE_NEAREST; mode<=SCALE_BILINEAR; mode++){
+	for(t=1; t<=max_threads; t*=2){
+
+		if(simd_select(isas[k]) < 0)
+			break;
+		if(pool_init(t) < 0){
+			pool_shutdown();
+			break;
+		}/*eo if*/
+		snprintf(name, sizeof(name), "scale-%s-%s-%dt", 
+			 mode == SCALE_NEAREST ? "nearest" : "bilinear", isas[k], t);
+
+		n = 0;
+		for(i=0; i<(int)(sizeof(sizes)/sizeof(sizes[0])); i++){
+			if(scale_init(&sc, mode, sizes[i][0], sizes[i][1], 
+				      sizes[i][2], sizes[i][3]) < 0){
+				n++;
+				continue;
+			}/*eo if*/
+			for(p=fbp; p<fbp+screensize/2; p++)
+				*p = 0xaaaa;
+			scale_rgb565(&sc, fbp, NULL, src, stride*2);
+
+			x0 = vinfo.xoffset + (vinfo.xres - sc.width)/2;
+			y0 = vinfo.yoffset + (vinfo.yres - sc.height)/2;
+			for(y=0; y<(int)vinfo.yres_virtual; y++){
+				p = (uint16_t *)((uint8_t *)fbp + 
+						 y*finfo.line_length);
+				for(x=0; x<(int)(finfo.line_length/2); x++){
+					expect = 0xaaaa;
+					if(y >= y0 && y < y0+sc.height && 
+					   x >= x0 && x < x0+sc.width)
+						expect = golden_scale(src, stride, 
+							sc.src_width, sc.src_height,
+							sc.width, sc.height, mode, 
+							x - x0, y - y0);
+					n += p[x] != expect;
+					if(sc.width == sc.src_width && 
+					   sc.height == sc.src_height &&
+					   expect != 0xaaaa)
+						n += expect != 
+							src[(y-y0)*stride + x-x0];
+				}/*eo for*/
+			}/*eo for*/
+			scale_free(&sc);
+		}/*eo for*/
+		pool_shutdown();
+		if(n)
+			fprintf(info, "%-24s %ld bad pixels\n", name, n);
+		bad += n;
+
+	}/*eo for*/
+	}/*eo for*/
+	}/*eo for*/
+	fprintf(info, "%-18s %ld bad pixels in a fake framebuffer\n", 
+		"scale_rgb565", bad);
+
+	init_simd();
+	free(src);
+	close_fb(&fb);
+
+	return(bad);
+
+}/*eo check_scale*/
+
+/*
+** check_compose
+** every layout and zoomed subband, unscaled, nearest and bilinear, 
+** keeping the aspect ratio and stretched, composed from a raw and a dwt
+** WQVGA frame into a fake 480x272 framebuffer with panning offsets. the
+** views must land centred in their regions (the screen, or its halves
+** for split) as golden_scale or 1:1 copies of their frames, and nothing
+** else may be written. returns the number of bad pixels.
+*/
+static long check_compose(void){
+
+	struct fake_fb fb = hvga_fb;
+	struct compositor c;
+	struct region rr[2];
+	uint16_t *raw=NULL, *dwt=NULL, *ref=NULL, *p=NULL;
+	const uint16_t *src=NULL;
+	long bad=0, n=0;
+	int i=0, v=0, nv=0, layout=0, band=0, mode=0, stretch=0;
+	int x=0, y=0, x0=0, y0=0, sw=0, sh=0, w=0, h=0, scaled=0;
+	int xres=HVGA_WIDTH, yres=HVGA_HEIGHT, fw=WQVGA_WIDTH, fh=WQVGA_HEIGHT;
+
+	raw = malloc(fw*fh*sizeof(uint16_t));
+	dwt = malloc(fw*fh*sizeof(uint16_t));
+	ref = malloc(xres*yres*sizeof(uint16_t));
+	if(raw == NULL || dwt == NULL || ref == NULL || 
+	   open_fb(&fb) < 0){
+		free(raw);
+		free(dwt);
+		free(ref);
+		return(-1);
+	}/*eo if*/
+	for(i=0; i<fw*fh; i++){
+		raw[i] = bench_rand();
+		dwt[i] = bench_rand();
+	}/*eo for*/
+	memset(&c, 0, sizeof(c));
+
+	for(layout=0; layout<NVIEW_LAYOUTS; layout++){
+	for(band=0; band<(layout == VIEW_ZOOM ? 4 : 1); band++){
+	for(mode=0; mode<=SCALE_BILINEAR; mode++){
+	for(stretch=0; stretch<2; stretch++){
+
+		if(compose_layout(&c, layout, band, mode, stretch) < 0){
+			bad++;
+			continue;
+		}/*eo if*/
+		for(p=fbp; p<fbp+screensize/2; p++)
+			*p = 0xaaaa;
+		compose(&c, fbp, raw, dwt);
+
+		/*
+		** expected visible area
+		*/
+		for(i=0; i<xres*yres; i++)
+			ref[i] = 0xaaaa;
+		nv = layout == VIEW_SPLIT ? 2 : 1;
+		rr[0] = (struct region){ 0, 0, xres, yres };
+		if(nv == 2){
+			rr[0].width = xres/2;
+			rr[1] = (struct region){ xres/2, 0, xres - xres/2, yres };
+		}/*eo if*/
+		for(v=0; v<nv; v++){
+			src = layout == VIEW_RAW || (nv == 2 && v == 0) ? raw : dwt;
+			sw = fw;
+			sh = fh;
+			if(layout == VIEW_ZOOM){
+				src += (band & 2 ? (fh/2)*fw : 0) + (band & 1 ? fw/2 : 0);
+				sw = fw/2;
+				sh = fh/2;
+			}/*eo if*/
+			w = rr[v].width;
+			h = rr[v].height;
+			if(!stretch)
+				scale_fit(sw, sh, &w, &h);
+			scaled = !((mode == 0 && layout != VIEW_ZOOM && 
+				    sw <= rr[v].width && sh <= rr[v].height) ||
+				   (w == sw && h == sh));
+			if(!scaled){
+				w = sw;
+				h = sh;
+			}/*eo if*/
+			x0 = rr[v].x + (rr[v].width - w)/2;
+			y0 = rr[v].y + (rr[v].height - h)/2;
+			for(y=0; y<h; y++)
+				for(x=0; x<w; x++)
+					ref[(y0 + y)*xres + x0 + x] = !scaled ? 
+						src[y*fw + x] : golden_scale(src, fw,
+						sw, sh, w, h, mode ? mode : 
+						SCALE_NEAREST, x, y);
+		}/*eo for*/
+
+		n = 0;
+		for(y=0; y<(int)vinfo.yres_virtual; y++){
+			p = (uint16_t *)((uint8_t *)fbp + y*finfo.line_length);
+			for(x=0; x<(int)(finfo.line_length/2); x++){
+				x0 = x - (int)vinfo.xoffset;
+				y0 = y - (int)vinfo.yoffset;
+				if(x0 >= 0 && x0 < xres && y0 >= 0 && y0 < yres)
+					n += p[x] != ref[y0*xres + x0];
+				else
+					n += p[x] != 0xaaaa;
+			}/*eo for*/
+		}/*eo for*/
+		if(n)
+			fprintf(info, "compose %s %s mode %d%s: %ld bad pixels\n",
+				view_layouts[layout], view_bands[band], mode, 
+				stretch ? " stretched" : "", n);
+		bad += n;
+
+	}/*eo for*/
+	}/*eo for*/
+	}/*eo for*/
+	}/*eo for*/
+
+	/*
+	** a split with 1 pixel wide views cannot be made, the zoomed
+	** layout in use has to stay
+	*/
+	if(compose_layout(&c, VIEW_ZOOM, 1, SCALE_NEAREST, 0) < 0)
+		bad++;
+	vinfo.xres = 2;
+	if(compose_layout(&c, VIEW_SPLIT, 0, SCALE_NEAREST, 0) == 0 ||
+	   c.layout != VIEW_ZOOM || c.band != 1 || c.nviews != 1 || 
+	   !c.v[0].scaled){
+		fprintf(info, "compose: a failed layout changed the one in "
+			"use\n");
+		bad++;
+	}/*eo if*/
+	vinfo.xres = xres;
+	compose_free(&c);
+	fprintf(info, "%-18s %ld bad pixels in a fake framebuffer\n", 
+		"compose", bad);
+
+	free(raw);
+	free(dwt);
+	free(ref);
+	close_fb(&fb);
+
+	return(bad);
+
+}/*eo check_compose*/
+
+/*
+** osd_area
+** bad pixels of a fake framebuffer filled with 0xaaaa after the overlay
+** text was drawn: every cell must show its glyph, nothing else written
+*/
+static long osd_area(char text[OSD_LINES][OSD_COLS + 1], int cols){
+
+	int zoom = osd_zoom(), top = osd_top(), x=0, y=0, cx=0, cy=0, c=0;
+	uint16_t *p=NULL, expect=0;
+	const uint8_t *g=NULL;
+	long n=0;
+
+	for(y=0; y<(int)vinfo.yres_virtual; y++){
+		p = (uint16_t *)((uint8_t *)fbp + y*finfo.line_length);
+		for(x=0; x<(int)(finfo.line_length/2); x++){
+			cx = x - (int)vinfo.xoffset - top;
+			cy = y - (int)vinfo.yoffset - top;
+			expect = 0xaaaa;
+			if(cx >= 0 && cx < cols*6*zoom && cy >= 0 && 
+			   cy < OSD_LINES*8*zoom){
+				c = text[cy/(8*zoom)][cx/(6*zoom)];
+				g = osd_glyph(c);
+				cx = cx/zoom % 6;
+				cy = cy/zoom % 8;
+				expect = cx < 5 && (g[cx] >> cy & 1) ? WHITE : BLACK;
+			}/*eo if*/
+			n += p[x] != expect;
+		}/*eo for*/
+	}/*eo for*/
+
+	return(n);
+
+}/*eo osd_area*/
+
+/*
+** check_osd
+** the overlay in fake framebuffers with panning offsets at cell size 1
+** and 2: full text, then only changed cells, cells overwritten by the
+** video, a spent budget, and the time of a full redraw against 
+** OSD_BUDGET_US. returns the number of bad pixels and cell counts.
+*/
+static long check_osd(void){
+
+	static const int screens[][6] = {	/*virtual, visible, offset*/
+		{ 496, 544, HVGA_WIDTH, HVGA_HEIGHT, 16, HVGA_HEIGHT },
+		{ 1296, 736, HD_WIDTH, HD_HEIGHT, 8, 16 }
+	};
+	struct fake_fb fb;
+	char text[OSD_LINES][OSD_COLS + 1];
+	struct timespec t0, t1;
+	uint16_t *p=NULL;
+	double ns=0, best=0;
+	long bad=0, n=0;
+	int i=0, j=0, cols=0, line=0, cells=0;
+
+	/*
+	** the digit one is a vertical bar with a foot and a flag
+	*/
+	if(memcmp(osd_glyph('1'), "\x00\x42\x7f\x40\x00", 5) != 0 || 
+	   osd_glyph('a') != osd_glyph('A') || osd_glyph('~') != osd_glyph(' '))
+		bad++;
+
+	for(i=0; i<2; i++){
+
+		fb = (struct fake_fb){ .width = screens[i][0], 
+			.height = screens[i][1], .xres = screens[i][2], 
+			.yres = screens[i][3], .xoffset = screens[i][4], 
+			.yoffset = screens[i][5] };
+		if(open_fb(&fb) < 0)
+			return(-1);
+		cols = (vinfo.xres - osd_top())/(6*osd_zoom());
+		if(cols > OSD_COLS)
+			cols = OSD_COLS;
+		for(p=fbp; p<fbp+screensize/2; p++)
+			*p = 0xaaaa;
+
+		/*
+		** everything once, then nothing
+		*/
+		snprintf(text[0], sizeof(text[0]), "%-40s", 
+			 " 29.9 FPS     12 DROP   54.3 MS %/:-");
+		snprintf(text[1], sizeof(text[1]), "%-40s", 
+			 "DQ 1.0 CVT 2.5 DWT 3.1 DSP 0.4 xyz");
+		osd_invalidate();
+		for(line=0; line<OSD_LINES; line++)
+			osd_printf(line, "%s", text[line]);
+		cells = osd_draw(fbp, 1000000);
+		n = (cells != OSD_LINES*cols) + osd_area(text, cols);
+		n += osd_draw(fbp, 1000000) != 0;
+
+		/*
+		** one changed character, one line overwritten by video
+		*/
+		text[0][3] = '8';
+		osd_printf(0, "%s", text[0]);
+		n += osd_draw(fbp, 1000000) != 1;
+		osd_damage(osd_top() + 8*osd_zoom() + 1, 1);
+		osd_damage(osd_top() + OSD_LINES*8*osd_zoom(), 100);
+		n += osd_draw(fbp, 1000000) != cols;
+		n += osd_area(text, cols);
+
+		/*
+		** a spent budget ends the draw after the first cell, the
+		** others follow one per frame
+		*/
+		osd_invalidate();
+		for(j=0; j<OSD_LINES*cols; j++)
+			n += osd_draw(fbp, 0) != 1;
+		n += osd_draw(fbp, 0) != 0;
+		n += osd_area(text, cols);
+
+		/*
+		** full redraw, the worst case of a frame
+		*/
+		for(j=0; j<=iterations; j++){
+			osd_invalidate();
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			osd_draw(fbp, 1000000);
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			ns = ns_diff(&t0, &t1);
+			if(j == 1 || (j > 1 && ns < best))
+				best = ns;
+		}/*eo for*/
+		fprintf(info, "%-18s %ld bad pixels or cell counts at %dx%d, "
+			"%d cells in %.1f us (budget %d us)\n", "osd_draw", n, 
+			vinfo.xres, vinfo.yres, cells, best/1000, OSD_BUDGET_US);
+		bad += n;
+
+		close_fb(&fb);
+
+	}/*eo for*/
+
+	osd_invalidate();
+
+	return(bad);
+
+}/*eo check_osd*/
+
+/*
+** bench_scale
+** time scale_rgb565 from a width x height frame to the largest frame a
+** 1920x1200 and a 480x272 fake framebuffer take, nearest and bilinear,
+** for every pool thread count. MB/s is written into the framebuffer.
+*/
+static void bench_scale(int width, int height){
+
+	static const int screens[][2] = { 
+		{ WUXGA_WIDTH, WUXGA_HEIGHT }, { HVGA_WIDTH, HVGA_HEIGHT } 
+	};
+	struct fake_fb fb;
+	struct scaler sc;
+	struct timespec t0, t1;
+	struct result r;
+	uint16_t *src=NULL;
+	double ns=0, best=0;
+	int i=0, j=0, t=0, mode=0, w=0, h=0;
+
+	src = malloc(width*height*sizeof(uint16_t));
+	if(src == NULL){
+		fprintf(info, "malloc failed\n");
+		return;
+	}/*eo if*/
+	for(i=0; i<width*height; i++)
+		src[i] = bench_rand();
+
+	for(i=0; i<2; i++){
+
+		fb = (struct fake_fb){ .width = screens[i][0], 
+			.height = screens[i][1] };
+		if(open_fb(&fb) < 0)
+			break;
+		w = screens[i][0];
+		h = screens[i][1];
+		if((long)width*h > (long)height*w)
+			h = (long)height*w/width;
+		else
+			w = (long)width*h/height;
+
+		for(mode=SCALE_NEAREST; mode<=SCALE_BILINEAR; mode++){
+			if(scale_init(&sc, mode, width, height, w, h) < 0)
+				break;
+			for(t=1; t<=max_threads; t*=2){
+				if(pool_init(t) < 0){
+					pool_shutdown();
+					break;
+				}/*eo if*/
+				for(j=0; j<=iterations; j++){
+					clock_gettime(CLOCK_MONOTONIC, &t0);
+					scale_rgb565(&sc, fbp, NULL, src, width*2);
+					clock_gettime(CLOCK_MONOTONIC, &t1);
+					ns = ns_diff(&t0, &t1);
+					if(j == 1 || (j > 1 && ns < best))
+						best = ns;
+				}/*eo for*/
+				pool_shutdown();
+				fprintf(info, "%4dx%-4d %-8s %4dx%-4d %3d %10.3f "
+					"%10.1f\n", width, height, 
+					mode == SCALE_NEAREST ? "nearest" : 
+					"bilinear", w, h, t, best/1000000, 
+					2000.0*w*h/best);
+
+				if(format != FMT_TEXT){
+					snprintf(r.name, sizeof(r.name), 
+						 "scale-%s-%dx%d-%dt", 
+						 mode == SCALE_NEAREST ? 
+						 "nearest" : "bilinear", w, h, t);
+					r.width = w;
+					r.height = h;
+					r.bytes = 2;
+					r.best = r.mean = best;
+					for(j=0; j<NPERF; j++)
+						r.perf[j] = -1;
+					emit(&r);
+				}/*eo if*/
+			}/*eo for*/
+			scale_free(&sc);
+		}/*eo for*/
+
+		close_fb(&fb);
+
+	}/*eo for*/
+
+	free(src);
+
+}/*eo bench_scale*/
+
+/*
+** check_geometry
+** run every kernel on a width x height capture frame with stride byte
+** lines and compare it with convert2() and HaarDwt() at the same
+** geometry. returns the number of kernels that differ.
+*/
+static long check_geometry(int width, int height, int stride){
+
+	struct geometry saved = cap_geo;
+	uint8_t *in=NULL, *ref=NULL, *ref_dwt=NULL, *out=NULL;
+	int size=width*height*2;
+	long bad=0;
+	int i=0;
+
+	cap_geo.width = width;
+	cap_geo.height = height;
+	cap_geo.stride = stride;
+
+	in = malloc(height*stride);
+	ref = malloc(size);
+	ref_dwt = malloc(size);
+	out = malloc(size);
+	if(in == NULL || ref == NULL || ref_dwt == NULL || out == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	for(i=0; i<height*stride; i++)
+		in[i] = bench_rand();
+
+	convert2(in, ref);
+	HaarDwt((uint16_t *)ref, (uint16_t *)ref_dwt);
+
+#define CHECK_KERNEL(name, call, expect) do{ \
+	memset(out, 0, size); \
+	call; \
+	if(memcmp(out, expect, size) != 0){ \
+		fprintf(info, "%-18s differs at %dx%d stride %d\n", name, width, \
+			height, stride); \
+		bad++; \
+	} \
+}while(0)
+
+	CHECK_KERNEL("convert3", convert3(in, out, lut_ptr), ref);
+	CHECK_KERNEL("convert4", convert4(in, out), ref);
+	CHECK_KERNEL("convert5", convert5(in, out), ref);
+	CHECK_KERNEL("HaarDwtStride", 
+		     HaarDwtStride((uint16_t *)ref, (uint16_t *)out, width), 
+		     ref_dwt);
+	CHECK_KERNEL("HaarDwtYuyv", HaarDwtYuyv(in, (uint16_t *)out), ref_dwt);
+	CHECK_KERNEL("HaarDwt2", HaarDwt2((uint16_t *)ref, (uint16_t *)out, 
+		     width, height, width), ref_dwt);
+#undef CHECK_KERNEL
+
+	fprintf(info, "%4dx%-4d stride %4d %ld kernels differ from convert2+HaarDwt\n",
+		width, height, stride, bad);
+
+	free(in);
+	free(ref);
+	free(ref_dwt);
+	free(out);
+	cap_geo = saved;
+
+	return(bad);
+
+}/*eo check_geometry*/
+
+/*
+** check_latency
+** every bucket holds the values from the end of the one before it to 
+** lat_bucket_max(), the last one ends at UINT32_MAX us, and samples 
+** past that (a stall of 72 minutes, a clock jump) land in it without
+** touching the memory that follows the histogram. returns the number 
+** of errors.
+*/
+static long check_latency(void){
+
+	static const int64_t stalls[] = {
+		(int64_t)UINT32_MAX*1000, (int64_t)UINT32_MAX*1000 + 999, 
+		(int64_t)UINT32_MAX*1000 + 1000, INT64_MAX
+	};
+	struct {
+		struct latency_hist h;
+		uint32_t guard[64];
+	} t;
+	uint32_t end=0;
+	long bad=0;
+	int i=0;
+
+	for(i=0; i<LAT_BUCKETS; i++){
+		bad += lat_bucket(lat_bucket_max(i)) != i;
+		bad += i > 0 && lat_bucket(end + 1) != i;
+		end = lat_bucket_max(i);
+	}/*eo for*/
+	bad += end != UINT32_MAX;
+
+	memset(&t, 0, sizeof(t));
+	t.h.name = "stall";
+	for(i=0; i<(int)(sizeof(stalls)/sizeof(stalls[0])); i++)
+		lat_add(&t.h, stalls[i]);
+	lat_add(&t.h, -1);
+	bad += t.h.bucket[LAT_BUCKETS-1] != 4 || t.h.bucket[0] != 1 ||
+	       t.h.count != 5 || t.h.max_us != UINT32_MAX;
+	for(i=0; i<64; i++)
+		bad += t.guard[i] != 0;
+
+	fprintf(info, "%-18s %ld errors in %d buckets up to %u us\n", 
+		"lat_add", bad, LAT_BUCKETS, end);
+
+	return(bad);
+
+}/*eo check_latency*/
+
+/*
+** golden reference kernels
+** golden_convert() is yuv422_to_rgb565() applied to every pixel, and
+** golden_haar() is the haar4.c HaarDwt() with the 512x512 constants
+** replaced by the frame size. every fast kernel must match them bit for
+** bit.
+*/
+static void golden_convert(uint8_t *in, uint16_t *out, int width, 
+			   int height, int stride){
+
+	uint8_t *p=NULL;
+	int x=0, y=0;
+
+	for(y=0; y<height; y++){
+		p = in + y*stride;
+		for(x=0; x<width; x+=2, p+=4){
+			/*
+			** macropixel bytes are Y1 V0 Y0 U0
+			*/
+			*out++ = yuv422_to_rgb565(p[2], p[3], p[1]);
+			*out++ = yuv422_to_rgb565(p[0], p[3], p[1]);
+		}/*eo for*/
+	}/*eo for*/
+
+}/*eo golden_convert*/
+
+static void golden_haar(uint16_t *imgin_ptr, uint16_t *imgout_ptr, 
+			int width, int height){
+
+	int i=0, j=0, k=0, h=0, c=0, quad_row_offset=0;
+	int quad_row_origin = (height/2)*width, quad_col_offset = width/2;
+	int r1c1=0, r1c2=0, r2c1=0, r2c2=0;
+	int a=0, b=0, d=0, e=0, max=0, shift=0;
+	int lp1=0, lp2=0, lp3=0, hp1=0, hp2=0, hp3=0;
+	uint8_t ll[3], lh[3], hl[3], hh[3];
+
+	/*
+	** two rows and two columns at a time, channel c is red, green or
+	** blue with the same arithmetic as haar4.c
+	*/
+	for(i=0; i<height; i+=2, h++){
+		quad_row_offset = width*h;
+		k = 0;
+		for(j=0; j<width; j+=2, k++){
+			r1c1 = imgin_ptr[width*i + j];
+			r1c2 = imgin_ptr[width*i + j + 1];
+			r2c1 = imgin_ptr[width*(i+1) + j];
+			r2c2 = imgin_ptr[width*(i+1) + j + 1];
+
+			for(c=0; c<3; c++){
+				shift = c == 0 ? 11 : c == 1 ? 5 : 0;
+				max = c == 1 ? 0x3f : 0x1f;
+				a = (r1c1 >> shift) & max;
+				b = (r1c2 >> shift) & max;
+				d = (r2c1 >> shift) & max;
+				e = (r2c2 >> shift) & max;
+
+				lp1 = (a+d)/2; if(lp1>max) lp1=max;
+				lp2 = (b+e)/2; if(lp2>max) lp2=max;
+				lp3 = (lp1+lp2)/2; if(lp3>max) lp3=max;
+				ll[c] = lp3;
+
+				hp1 = abs((lp1-lp2)/2); if(hp1>max) hp1=max;
+				lh[c] = hp1*10;
+
+				hp1 = abs((a-d)/2); if(hp1>max) hp1=max;
+				hp2 = abs((b-e)/2); if(hp2>max) hp2=max;
+				lp1 = (hp1+hp2)/2; if(lp1>max) lp1=max;
+				hl[c] = lp1*10;
+
+				hp3 = abs((hp1-hp2)/2); if(hp3>max) hp3=max;
+				hh[c] = hp3*10;
+			}/*eo for*/
+
+			imgout_ptr[quad_row_offset + k] = 
+				(ll[0] << 11) | (ll[1] << 5) | ll[2];
+			imgout_ptr[quad_col_offset + quad_row_offset + k] = 
+				(lh[0] << 11) | (lh[1] << 5) | lh[2];
+			imgout_ptr[quad_row_origin + quad_row_offset + k] = 
+				(hl[0] << 11) | (hl[1] << 5) | hl[2];
+			imgout_ptr[quad_row_origin + quad_col_offset + 
+				   quad_row_offset + k] = 
+				(hh[0] << 11) | (hh[1] << 5) | hh[2];
+		}/*eo for*/
+	}/*eo for*/
+
+}/*eo golden_haar*/
+
+/*
+** golden luma path, the Y samples in convert2() pixel order and the 
+** golden_haar() arithmetic on one 8 bit channel with the detail gain
+** saturated at 255
+*/
+static void golden_luma(uint8_t *in, uint8_t *out, int width, int height, 
+			int stride){
+
+	int x=0, y=0;
+
+	for(y=0; y<height; y++){
+		for(x=0; x<width; x+=2){
+			*out++ = in[y*stride + 2*x + 2];	/*Y0*/
+			*out++ = in[y*stride + 2*x];		/*Y1*/
+		}/*eo for*/
+	}/*eo for*/
+
+}/*eo golden_luma*/
+
+static void golden_haar_gray(uint8_t *in, uint8_t *out, int width, 
+			     int height){
+
+	int i=0, j=0, h=0, k=0, q=(height/2)*width;
+	int a=0, b=0, d=0, e=0, lp1=0, lp2=0, hp1=0, hp2=0, hp3=0;
+
+	for(i=0; i<height; i+=2, h++){
+		for(j=0, k=0; j<width; j+=2, k++){
+			a = in[width*i + j];
+			b = in[width*i + j + 1];
+			d = in[width*(i+1) + j];
+			e = in[width*(i+1) + j + 1];
+
+			lp1 = (a+d)/2;
+			lp2 = (b+e)/2;
+			out[width*h + k] = (lp1+lp2)/2;
+
+			hp1 = abs((lp1-lp2)/2);
+			out[width*h + width/2 + k] = hp1*10 > 255 ? 255 : hp1*10;
+
+			hp1 = abs((a-d)/2);
+			hp2 = abs((b-e)/2);
+			lp1 = (hp1+hp2)/2;
+			out[q + width*h + k] = lp1*10 > 255 ? 255 : lp1*10;
+
+			hp3 = abs((hp1-hp2)/2);
+			out[q + width*h + width/2 + k] = 
+				hp3*10 > 255 ? 255 : hp3*10;
+		}/*eo for*/
+	}/*eo for*/
+
+}/*eo golden_haar_gray*/
+
+/*
+** golden_lift
+** levels of the S-transform on a packed int16 plane, each level computed
+** from a copy of the LL block straight from the definition
+*/
+static void golden_lift(int16_t *p, int width, int height, int levels){
+
+	int16_t *t = malloc(width*height*sizeof(int16_t));
+	int l=0, x=0, y=0, w=width, h=height;
+	int a=0, b=0, c=0, e=0, s0=0, s1=0, d0=0, d1=0;
+
+	for(l=0; l<levels && t; l++, w/=2, h/=2){
+		for(y=0; y<h; y++)
+			memcpy(t + y*w, p + y*width, w*sizeof(int16_t));
+		for(y=0; y<h; y+=2){
+			for(x=0; x<w; x+=2){
+				a = t[y*w + x];	b = t[y*w + x + 1];
+				c = t[(y+1)*w + x]; e = t[(y+1)*w + x + 1];
+
+				/*
+				** rows, then columns of the smooth and detail
+				** values
+				*/
+				d0 = a - b; s0 = b + (d0 >> 1);
+				d1 = c - e; s1 = e + (d1 >> 1);
+				p[(y/2)*width + x/2] = s1 + ((s0 - s1) >> 1);
+				p[(y/2)*width + w/2 + x/2] = d1 + ((d0 - d1) >> 1);
+				p[(h/2 + y/2)*width + x/2] = s0 - s1;
+				p[(h/2 + y/2)*width + w/2 + x/2] = d0 - d1;
+			}/*eo for*/
+		}/*eo for*/
+	}/*eo for*/
+	free(t);
+
+}/*eo golden_lift*/
+
+/*
+** plane_diff
+** compare three width x height planes, report the first difference and
+** return 1 if there is one
+*/
+static long plane_diff(char *name, int16_t *out, int16_t *ref, int width,
+		       int height, int levels, char *frame){
+
+	int n = width*height, i=0, c=0;
+
+	for(i=0; i<3*n; i++){
+		if(out[i] != ref[i])
+			break;
+	}/*eo for*/
+	if(i == 3*n)
+		return(0);
+	c = i / n;
+	i = i % n;
+	fprintf(info, "%-18s %s %dx%d: %d levels, plane %d first difference "
+		"at x=%d y=%d %d != %d\n", name, frame, width, height, levels,
+		c, i % width, i / width, out[c*n + i], ref[c*n + i]);
+
+	return(1);
+
+}/*eo plane_diff*/
+
+/*
+** check_lift
+** HaarLift and HaarLift2 of the three planes of an rgb565 frame at every
+** depth against golden_lift, then HaarUnlift and HaarUnlift2 back to the
+** planes and PlanesToRgb565 back to the frame. the threaded functions
+** run with 1, 2, 4 .. max_threads pool threads. returns the number of
+** mismatches.
+*/
+static long check_lift(uint16_t *rgb, int width, int height, char *frame){
+
+	int n = width*height, levels=0, max=0, c=0, t=0;
+	int16_t *planes = malloc(3*n*sizeof(int16_t));
+	int16_t *ref = malloc(3*n*sizeof(int16_t));
+	int16_t *orig = malloc(3*n*sizeof(int16_t));
+	uint16_t *out = malloc(n*sizeof(uint16_t));
+	char name[32];
+	long bad=0;
+
+	if(planes == NULL || ref == NULL || orig == NULL || out == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	max = lift_levels(width, height, LIFT_MAX_LEVELS);
+	Rgb565ToPlanes(rgb, orig, width, height);
+
+	for(levels=1; levels<=max; levels++){
+		memcpy(ref, orig, 3*n*sizeof(int16_t));
+		for(c=0; c<3; c++)
+			golden_lift(ref + c*n, width, height, levels);
+
+		/*
+		** single thread, then the pool at every thread count
+		*/
+		for(t=0; t<=max_threads; t = t ? 2*t : 1){
+			if(t && pool_init(t) < 0){
+				pool_shutdown();
+				break;
+			}/*eo if*/
+			snprintf(name, sizeof(name), t ? "HaarLift2-%dt" : 
+				 "HaarLift", t);
+			memcpy(planes, orig, 3*n*sizeof(int16_t));
+			for(c=0; c<3; c++){
+				if(t) HaarLift2(planes + c*n, width, height, 
+						width, levels);
+				else HaarLift(planes + c*n, width, height, 
+					      width, levels);
+			}/*eo for*/
+			bad += plane_diff(name, planes, ref, width, height, 
+					  levels, frame);
+
+			snprintf(name, sizeof(name), t ? "HaarUnlift2-%dt" : 
+				 "HaarUnlift", t);
+			for(c=0; c<3; c++){
+				if(t) HaarUnlift2(planes + c*n, width, height,
+						  width, levels);
+				else HaarUnlift(planes + c*n, width, height,
+						width, levels);
+			}/*eo for*/
+			bad += plane_diff(name, planes, orig, width, height, 
+					  levels, frame);
+
+			memset(out, 0, n*sizeof(uint16_t));
+			PlanesToRgb565(planes, out, width, height);
+			if(memcmp(out, rgb, n*sizeof(uint16_t)) != 0){
+				fprintf(info, "%-18s %s %dx%d: %d levels, frame"
+					" differs after the round trip\n", 
+					"PlanesToRgb565", frame, width, height,
+					levels);
+				bad++;
+			}/*eo if*/
+			if(t) pool_shutdown();
+		}/*eo for*/
+	}/*eo for*/
+
+	free(planes);
+	free(ref);
+	free(orig);
+	free(out);
+
+	return(bad);
+
+}/*eo check_lift*/
+
+/*
+** check_lift_simd
+** HaarLift, HaarUnlift, HaarDenoise (soft and hard) and their pool
+** versions with every simd kernel against the scalar kernels on random
+** coefficients over the whole int16 range, where every step wraps. 
+** returns the number of mismatches.
+*/
+enum { LIFT_FWD, LIFT_INV, LIFT_SOFT, LIFT_HARD, NLIFT_OPS };
+static char *lift_ops[NLIFT_OPS] = { "HaarLift", "HaarUnlift", 
+				     "HaarDenoise-soft", "HaarDenoise-hard" };
+
+static void lift_op(int op, int16_t *p, int width, int height, int levels,
+		    int pool){
+
+	if(op == LIFT_FWD && pool) HaarLift2(p, width, height, width, levels);
+	if(op == LIFT_FWD && !pool) HaarLift(p, width, height, width, levels);
+	if(op == LIFT_INV && pool) HaarUnlift2(p, width, height, width, levels);
+	if(op == LIFT_INV && !pool) HaarUnlift(p, width, height, width, levels);
+	if(op == LIFT_SOFT || op == LIFT_HARD)
+		HaarDenoise(p, width, height, width, levels, 
+			    DENOISE_MAX_THRESH/2, op == LIFT_SOFT);
+
+}/*eo lift_op*/
+
+static long check_lift_simd(int width, int height){
+
+	int n = width*height, levels=0, max=0, i=0, t=0, op=0;
+	int16_t *orig = malloc(3*n*sizeof(int16_t));
+	int16_t *ref = malloc(3*n*sizeof(int16_t));
+	int16_t *planes = malloc(3*n*sizeof(int16_t));
+	char name[48];
+	long bad=0;
+
+	if(orig == NULL || ref == NULL || planes == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	for(i=0; i<3*n; i++)
+		orig[i] = bench_rand();
+	max = lift_levels(width, height, LIFT_MAX_LEVELS);
+
+	for(levels=1; levels<=max; levels++){
+		for(op=0; op<NLIFT_OPS; op++){
+			simd_select("scalar");
+			memcpy(ref, orig, 3*n*sizeof(int16_t));
+			lift_op(op, ref, width, height, levels, 0);
+			for(i=1; i<(int)(sizeof(isas)/sizeof(isas[0])); i++){
+				if(simd_select(isas[i]) < 0)
+					continue;
+				for(t=0; t<=2; t+=2){
+					if(t && pool_init(t) < 0){
+						pool_shutdown();
+						break;
+					}/*eo if*/
+					snprintf(name, sizeof(name), "%s-%s%s", 
+						 lift_ops[op], isas[i], 
+						 t ? "-2t" : "");
+					memcpy(planes, orig, 3*n*sizeof(int16_t));
+					lift_op(op, planes, width, height, levels,
+						t);
+					bad += plane_diff(name, planes, ref, 
+							  width, height, levels,
+							  "random int16");
+					if(t) pool_shutdown();
+				}/*eo for*/
+			}/*eo for*/
+		}/*eo for*/
+	}/*eo for*/
+	init_simd();
+
+	free(orig);
+	free(ref);
+	free(planes);
+
+	return(bad);
+
+}/*eo check_lift_simd*/
+
+/*
+** check_denoise
+** DenoiseRgb565 at several thresholds, soft and hard, every simd kernel
+** and every pool thread count against golden_lift with every coefficient outside the
+** final LL block thresholded, HaarUnlift and PlanesToRgb565. returns 
+** the number of mismatches.
+*/
+static int denoise_thresh[] = { 0, 1, 4, 9 };
+
+static long check_denoise(uint16_t *rgb, int width, int height, 
+			  char *frame){
+
+	int n = width*height, levels=0, i=0, j=0, c=0, t=0, soft=0, x=0, y=0;
+	int isa=0;
+	int16_t *planes = malloc(3*n*sizeof(int16_t)), *p=NULL;
+	uint16_t *ref = malloc(n*sizeof(uint16_t));
+	uint16_t *out = malloc(n*sizeof(uint16_t));
+	long bad=0;
+
+	if(planes == NULL || ref == NULL || out == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	levels = lift_levels(width, height, DENOISE_LEVELS);
+
+	for(i=0; i<(int)(sizeof(denoise_thresh)/sizeof(int)); i++){
+		for(soft=0; soft<2; soft++){
+
+			/*
+			** reference frame
+			*/
+			Rgb565ToPlanes(rgb, planes, width, height);
+			for(c=0; c<3; c++){
+				p = planes + c*n;
+				t = c == 1 ? denoise_thresh[i] : 
+					     (denoise_thresh[i] + 1)/2;
+				golden_lift(p, width, height, levels);
+				for(y=0; y<height; y++){
+					for(x=0; x<width; x++){
+						j = p[y*width + x];
+						if(x < width >> levels && 
+						   y < height >> levels)
+							continue;	/*LL*/
+						if(j >= -t && j <= t)
+							p[y*width + x] = 0;
+						else if(soft)
+							p[y*width + x] = j > t ? 
+								j - t : j + t;
+					}/*eo for*/
+				}/*eo for*/
+				HaarUnlift(p, width, height, width, levels);
+			}/*eo for*/
+			PlanesToRgb565(planes, ref, width, height);
+
+			for(t=1; t<=max_threads; t*=2){
+				if(pool_init(t) < 0){
+					pool_shutdown();
+					break;
+				}/*eo if*/
+				for(isa=0; isa<(int)(sizeof(isas)/sizeof(isas[0]));
+				    isa++){
+					if(simd_select(isas[isa]) < 0)
+						continue;
+					memset(out, 0, n*sizeof(uint16_t));
+					DenoiseRgb565(rgb, out, planes, width, 
+						      height, denoise_thresh[i],
+						      soft);
+					for(j=0; j<n; j++){
+						if(out[j] != ref[j])
+							break;
+					}/*eo for*/
+					if(j == n)
+						continue;
+					fprintf(info, "%-18s %s %dx%d: threshold"
+						" %d %s %s %d threads, first "
+						"difference at x=%d y=%d %04x != "
+						"%04x\n", "DenoiseRgb565", frame, 
+						width, height, denoise_thresh[i], 
+						soft ? "soft" : "hard", isas[isa],
+						t, j % width, j / width, out[j], 
+						ref[j]);
+					bad++;
+				}/*eo for*/
+				pool_shutdown();
+			}/*eo for*/
+			init_simd();
+
+		}/*eo for*/
+	}/*eo for*/
+
+	free(planes);
+	free(ref);
+	free(out);
+
+	return(bad);
+
+}/*eo check_denoise*/
+
+/*
+** gray_diff
+** golden_diff() for 8 bit frames
+*/
+static long gray_diff(char *name, uint8_t *out, uint8_t *expect, int width,
+		      int height, char *frame){
+
+	int i=0;
+
+	for(i=0; i<width*height; i++){
+		if(out[i] != expect[i])
+			break;
+	}/*eo for*/
+	if(i == width*height)
+		return(0);
+
+	fprintf(info, "%-18s %s %dx%d: first difference at x=%d y=%d "
+		"%02x != %02x\n", name, frame, width, height, i % width, 
+		i / width, out[i], expect[i]);
+
+	return(1);
+
+}/*eo gray_diff*/
+
+/*
+** regression frames and sizes
+*/
+static struct geometry golden[] = {
+	{ WQVGA_WIDTH, WQVGA_HEIGHT, WQVGA_WIDTH*2 + 64, 0 },
+	{ VGA_WIDTH, VGA_HEIGHT, VGA_WIDTH*2, 0 },
+	{ HD_WIDTH, HD_HEIGHT, HD_WIDTH*2 + 128, 0 },
+	{ 178, 146, 178*2 + 32, 0 },
+	{ 30, 22, 30*2, 0 },
+	{ 2, 2, 2*2, 0 },
+	{ 178, 147, 178*2, 0 },
+};
+#define NGOLDEN	(int)(sizeof(golden)/sizeof(golden[0]))
+
+enum { FRAME_RANDOM, FRAME_BLACK, FRAME_WHITE, FRAME_CHROMA, NFRAMES };
+static char *frame_name[NFRAMES] = { "random", "black", "white", 
+				     "saturated" };
+
+static void golden_fill(uint8_t *in, int width, int height, int stride, 
+			int frame){
+
+	uint8_t *p=NULL;
+	int x=0, y=0;
+
+	for(y=0; y<height; y++){
+		p = in + y*stride;
+		for(x=0; x<width; x+=2, p+=4){
+			switch(frame){
+			case FRAME_BLACK:
+				p[0] = p[2] = 0; p[1] = p[3] = 128;
+				break;
+			case FRAME_WHITE:
+				p[0] = p[2] = 255; p[1] = p[3] = 128;
+				break;
+			case FRAME_CHROMA:
+				/*
+				** every corner of the uv plane, luma at both
+				** ends and random
+				*/
+				p[0] = (x & 2) ? 255 : 0;
+				p[2] = bench_rand();
+				p[1] = (x & 4) ? 255 : 0;
+				p[3] = ((x + y) & 8) ? 255 : 0;
+				break;
+			default:
+				p[0] = bench_rand(); p[1] = bench_rand();
+				p[2] = bench_rand(); p[3] = bench_rand();
+				break;
+			}/*eo switch*/
+		}/*eo for*/
+	}/*eo for*/
+
+}/*eo golden_fill*/
+
+/*
+** golden_diff
+** compare a frame with the golden one and report the first differing 
+** pixel, with its yuv input for conversion kernels. returns 1 on a 
+** mismatch.
+*/
+static long golden_diff(char *name, uint16_t *out, uint16_t *expect, 
+			int width, int height, char *frame, uint8_t *yuv, 
+			int stride){
+
+	uint8_t *p=NULL;
+	int i=0, x=0, y=0;
+
+	for(i=0; i<width*height; i++){
+		if(out[i] != expect[i])
+			break;
+	}/*eo for*/
+	if(i == width*height)
+		return(0);
+
+	x = i % width;
+	y = i / width;
+	fprintf(info, "%-18s %s %dx%d: first difference at x=%d y=%d "
+		"%04x != %04x", name, frame, width, height, x, y, out[i], 
+		expect[i]);
+	if(yuv){
+		p = yuv + y*stride + (x & ~1)*2;
+		fprintf(info, " (Y=%d U=%d V=%d)", p[(x & 1) ? 0 : 2], p[3], p[1]);
+	}/*eo if*/
+	fprintf(info, "\n");
+
+	return(1);
+
+}/*eo golden_diff*/
+
+/*
+** check_golden
+** run every conversion kernel, every simd variant and HaarDwt2 thread
+** count on one regression frame against the golden kernels. the haar 
+** kernels are only checked at even heights. returns the number of 
+** kernels that differ.
+*/
+static long check_golden(int width, int height, int stride, int frame){
+
+	struct geometry saved = cap_geo;
+	uint8_t *in=NULL;
+	uint16_t *ref=NULL, *ref_dwt=NULL, *out=NULL;
+	char name[32], *fname=frame_name[frame];
+	int size=width*height*2;
+	long bad=0;
+	int i=0, n=0;
+
+	cap_geo.width = width;
+	cap_geo.height = height;
+	cap_geo.stride = stride;
+
+	in = malloc(height*stride);
+	ref = malloc(size);
+	ref_dwt = malloc(size);
+	out = malloc(size);
+	if(in == NULL || ref == NULL || ref_dwt == NULL || out == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	memset(in, 0, height*stride);
+	golden_fill(in, width, height, stride, frame);
+	golden_convert(in, ref, width, height, stride);
+	if((height & 1) == 0)
+		golden_haar(ref, ref_dwt, width, height);
+
+#define GOLDEN(kname, call, expect, yuv) do{ \
+	memset(out, 0, size); \
+	call; \
+	bad += golden_diff(kname, out, expect, width, height, fname, yuv, \
+			   stride); \
+}while(0)
+
+	init_simd();
+	GOLDEN("convert2", convert2(in, (uint8_t *)out), ref, in);
+	GOLDEN("convert3", convert3(in, (uint8_t *)out, lut_ptr), ref, in);
+	GOLDEN("convert4", convert4(in, (uint8_t *)out), ref, in);
+
+	for(i=0; i<(int)(sizeof(isas)/sizeof(isas[0])); i++){
+
+		if(simd_select(isas[i]) < 0)
+			continue;
+
+		snprintf(name, sizeof(name), "convert5-%s", isas[i]);
+		GOLDEN(name, convert5(in, (uint8_t *)out), ref, in);
+		if(height & 1)
+			continue;
+
+		snprintf(name, sizeof(name), "HaarDwt-%s", isas[i]);
+		GOLDEN(name, HaarDwt(ref, out), ref_dwt, NULL);
+		snprintf(name, sizeof(name), "HaarDwtStride-%s", isas[i]);
+		GOLDEN(name, HaarDwtStride(ref, out, width), ref_dwt, NULL);
+		snprintf(name, sizeof(name), "HaarDwtYuyv-%s", isas[i]);
+		GOLDEN(name, HaarDwtYuyv(in, out), ref_dwt, NULL);
+
+		for(n=1; n<=max_threads; n*=2){
+			if(pool_init(n) < 0){
+				pool_shutdown();
+				break;
+			}/*eo if*/
+			snprintf(name, sizeof(name), "HaarDwt2-%s-%dt", isas[i], n);
+			GOLDEN(name, HaarDwt2(ref, out, width, height, width), 
+			       ref_dwt, NULL);
+			pool_shutdown();
+		}/*eo for*/
+
+	}/*eo for*/
+	init_simd();
+#undef GOLDEN
+
+	/*
+	** luma path, the golden gray frames go in ref and ref_dwt
+	*/
+	golden_luma(in, (uint8_t *)ref, width, height, stride);
+	memset(out, 0, size);
+	LumaExtract(in, (uint8_t *)out);
+	bad += gray_diff("LumaExtract", (uint8_t *)out, (uint8_t *)ref, width,
+			 height, fname);
+	if((height & 1) == 0){
+		golden_haar_gray((uint8_t *)ref, (uint8_t *)ref_dwt, width, 
+				 height);
+		memset(out, 0, size);
+		HaarDwtGray((uint8_t *)ref, (uint8_t *)out);
+		bad += gray_diff("HaarDwtGray", (uint8_t *)out, 
+				 (uint8_t *)ref_dwt, width, height, fname);
+	}/*eo if*/
+
+	/*
+	** integer lifting of the golden rgb565 frame at every depth
+	*/
+	golden_convert(in, ref, width, height, stride);
+	bad += check_lift(ref, width, height, fname);
+	bad += check_denoise(ref, width, height, fname);
+	if(frame == FRAME_RANDOM)
+		bad += check_lift_simd(width, height);
+
+	free(in);
+	free(ref);
+	free(ref_dwt);
+	free(out);
+	cap_geo = saved;
+
+	return(bad);
+
+}/*eo check_golden*/
+
+/*
+** measure
+** time iterations runs of a kernel on the cap_geo frame after a warm up
+** run, the perf counters cover all timed runs
+*/
+static void measure(char *name, void (*run)(void), struct result *r){
+
+	struct timespec t0, t1;
+	double t=0, total=0;
+	int i=0;
+
+	snprintf(r->name, sizeof(r->name), "%s", name);
+	r->width = cap_geo.width;
+	r->height = cap_geo.height;
+	r->best = 0;
+
+	/*
+	** warm up caches and tables
+	*/
+	run();
+
+	perf_start();
+	for(i=0; i<iterations; i++){
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		run();
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		t = ns_diff(&t0, &t1);
+		if(i == 0 || t < r->best) r->best = t;
+		total += t;
+	}/*eo for*/
+	perf_stop(r->perf);
+	r->mean = total/iterations;
+
+	for(i=0; i<NPERF; i++){
+		if(r->perf[i] >= 0)
+			r->perf[i] /= iterations;
+	}/*eo for*/
+
+}/*eo measure*/
+
+/*
+** bench_size
+** time every kernel the cpu supports on a width x height frame
+*/
+static int bench_size(int width, int height){
+
+	struct result r;
+	int i=0;
+
+	cap_geo.width = width;
+	cap_geo.height = height;
+	cap_geo.stride = width*2;
+
+	yuyv = malloc(width*height*2);
+	rgb565 = malloc(width*height*2);
+	dwt = malloc(width*height*2);
+	planes = malloc(3*width*height*sizeof(int16_t));
+	if(yuyv == NULL || rgb565 == NULL || dwt == NULL || planes == NULL){
+		fprintf(info, "malloc failed\n");
+		return(-1);
+	}/*eo if*/
+	for(i=0; i<width*height*2; i++)
+		yuyv[i] = bench_rand();
+	convert2(yuyv, rgb565);
+	HaarDwt((uint16_t *)rgb565, (uint16_t *)dwt);
+
+	if(format == FMT_TEXT){
+		printf("%dx%d yuyv422 -> rgb565 / haar dwt, %d iterations\n", 
+		       width, height, iterations);
+		printf("%-18s %10s %10s %9s %9s %9s %9s %9s\n", "kernel", "best", 
+		       "mean", "", "cycles", "instr", "cache", "dtlb");
+		printf("%-18s %10s %10s %9s %9s %9s %9s %9s\n", "", "ns/pixel", 
+		       "ns/pixel", "MB/s", "/pixel", "/pixel", "miss/fr", 
+		       "miss/fr");
+	}/*eo if*/
+
+	for(i=0; i<NKERNELS; i++){
+		if(kernel_select(&kernels[i]) < 0)
+			continue;
+		measure(kernels[i].name, kernels[i].run, &r);
+		r.bytes = kernels[i].bytes;
+		emit(&r);
+	}/*eo for*/
+	init_simd();
+
+	free(yuyv);
+	free(rgb565);
+	free(dwt);
+	free(planes);
+	yuyv = rgb565 = dwt = NULL;
+	planes = NULL;
+	cap_geo.width = WQVGA_WIDTH;
+	cap_geo.height = WQVGA_HEIGHT;
+	cap_geo.stride = WQVGA_WIDTH*2;
+
+	return(0);
+
+}/*eo bench_size*/
+
+int main(int argc, char *argv[]){
+
+	char *lutfile=NULL, *p=NULL;
+	uint8_t *ref=NULL, *ref_dwt=NULL;
+	struct fake_fb fb;
+	long bad=0, n=0;
+	int opt=0, i=0, j=0, nsizes=0, fb_width=0, fb_height=0, golden_only=0;
+	int width[MAX_SIZES], height[MAX_SIZES];
+
+	while((opt = getopt(argc, argv, "f:gHi:l:s:t:")) != -1){
+		switch(opt){
+		case 'H':
+			lut_huge = 1;
+			break;
+		case 'g':
+			golden_only = 1;
+			break;
+		case 'i':
+			iterations = atoi(optarg);
+			if(iterations < 1) iterations = 1;
+			break;
+		case 'l':
+			lutfile = optarg;
+			break;
+		case 't':
+			max_threads = atoi(optarg);
+			if(max_threads < 1) max_threads = 1;
+			break;
+		case 's':
+			sizes = optarg;
+			break;
+		case 'f':
+			if(strcmp(optarg, "text") == 0) format = FMT_TEXT;
+			else if(strcmp(optarg, "csv") == 0) format = FMT_CSV;
+			else if(strcmp(optarg, "json") == 0) format = FMT_JSON;
+			else{
+				fprintf(stderr, "unknown format %s\n", optarg);
+				return(1);
+			}/*eo if*/
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-g] [-H] [-i iterations] "
+				"[-l lutfile] [-t threads] [-s WxH[,WxH...]] "
+				"[-f text|csv|json]\n", argv[0]);
+			return(1);
+		}/*eo switch*/
+	}/*eo while*/
+	info = format == FMT_TEXT ? stdout : stderr;
+
+	/*
+	** frame sizes, the haar dwt needs even dimensions
+	*/
+	for(p=sizes; *p && nsizes < MAX_SIZES; nsizes++){
+		if(sscanf(p, "%dx%d", &width[nsizes], &height[nsizes]) != 2 ||
+		   width[nsizes] < 2 || height[nsizes] < 2 || 
+		   width[nsizes] > MAX_FRAME_WIDTH || (width[nsizes] & 1) || 
+		   (height[nsizes] & 1)){
+			fprintf(stderr, "bad frame size %s\n", p);
+			return(1);
+		}/*eo if*/
+		if(width[nsizes] > fb_width) fb_width = width[nsizes];
+		if(height[nsizes] > fb_height) fb_height = height[nsizes];
+		p += strcspn(p, ",");
+		if(*p == ',') p++;
+	}/*eo for*/
+
+	/*
+	** conversion tables
+	*/
+	if(lutfile){
+		if(lut_load(lutfile) < 0)
+			return(1);
+	}else{
+		if((lut_ptr = build_lut()) == NULL){
+			fprintf(info, "lut - malloc failed\n");
+			return(1);
+		}/*eo if*/
+		lut_mode = "malloc";
+		if(lut_huge && lut_hugepages() < 0)
+			return(1);
+	}/*eo if*/
+	lut_report(info);
+	init_simd();
+
+	/*
+	** the table and simd kernels must reproduce yuv422_to_rgb565() 
+	** exactly for all 2^24 inputs
+	*/
+	bad = check_pixels("convert4", convert4_pixels);
+	fprintf(info, "%-18s %ld of 16777216 yuv triples differ from "
+		"yuv422_to_rgb565\n", "convert4", bad);
+	for(i=0; i<NKERNELS; i++){
+		if(kernels[i].isa == NULL || kernel_select(&kernels[i]) < 0)
+			continue;
+		n = check_pixels(kernels[i].name, convert5_pixels);
+		fprintf(info, "%-18s %ld of 16777216 yuv triples differ from "
+			"yuv422_to_rgb565\n", kernels[i].name, n);
+		bad += n;
+	}/*eo for*/
+	if(bad)
+		return(1);
+
+	/*
+	** pseudo-random yuyv422 input frame
+	*/
+	yuyv = malloc(YUYV_SIZE);
+	rgb565 = malloc(RGB565_SIZE);
+	dwt = malloc(RGB565_SIZE);
+	ref = malloc(RGB565_SIZE);
+	ref_dwt = malloc(RGB565_SIZE);
+	planes = malloc(3*WQVGA_WIDTH*WQVGA_HEIGHT*sizeof(int16_t));
+	if(yuyv == NULL || rgb565 == NULL || dwt == NULL || ref == NULL ||
+	   ref_dwt == NULL || planes == NULL){
+		fprintf(info, "malloc failed\n");
+		return(1);
+	}/*eo if*/
+	for(i=0; i<YUYV_SIZE; i++)
+		yuyv[i] = bench_rand();
+
+	/*
+	** benchmark framebuffer for display_LCD4, large enough for the
+	** biggest benchmark frame
+	*/
+	fb = (struct fake_fb){ .width = fb_width + 32, .height = fb_height + 32 };
+	if(open_fb(&fb) < 0)
+		return(1);
+
+	/*
+	** every kernel must produce the convert2 (and HaarDwt) frame
+	*/
+	convert2(yuyv, ref);
+	HaarDwt((uint16_t *)ref, (uint16_t *)ref_dwt);
+	init_simd();
+	for(i=0; i<NKERNELS; i++){
+		if(kernel_select(&kernels[i]) < 0 || 
+		   kernels[i].out == OUT_GRAY || kernels[i].out == OUT_PLANES)
+			continue;
+		memset(rgb565, 0, RGB565_SIZE);
+		memset(dwt, 0, RGB565_SIZE);
+		if(kernels[i].in == IN_RGB565) memcpy(rgb565, ref, RGB565_SIZE);
+		if(kernels[i].in == IN_DWT) memcpy(dwt, ref_dwt, RGB565_SIZE);
+		kernels[i].run();
+		if(kernels[i].out == OUT_FB){
+			uint16_t *row = fb_origin(fbp, WQVGA_WIDTH, 
+						 WQVGA_HEIGHT);
+
+			for(n=0; n<WQVGA_HEIGHT; n++){
+				if(memcmp(row, ref_dwt + n*WQVGA_WIDTH*2, 
+					  WQVGA_WIDTH*2) != 0)
+					break;
+				row += finfo.line_length/2;
+			}/*eo for*/
+			if(n == WQVGA_HEIGHT)
+				continue;
+			fprintf(info, "%s framebuffer differs from HaarDwt\n",
+				kernels[i].name);
+			return(1);
+		}/*eo if*/
+		if(memcmp(kernels[i].out == OUT_DWT ? dwt : rgb565, 
+			  kernels[i].out == OUT_DWT ? ref_dwt : ref, 
+			  RGB565_SIZE) != 0){
+			fprintf(info, "%s output differs from convert2%s\n", 
+				kernels[i].name, kernels[i].out == OUT_RGB565 ? 
+				"" : "+HaarDwt");
+			return(1);
+		}/*eo if*/
+	}/*eo for*/
+
+	/*
+	** run-time geometry, the specialized sizes and a generic one, with
+	** packed and padded capture lines
+	*/
+	bad = check_geometry(WQVGA_WIDTH, WQVGA_HEIGHT, WQVGA_WIDTH*2 + 64);
+	bad += check_geometry(VGA_WIDTH, VGA_HEIGHT, VGA_WIDTH*2);
+	bad += check_geometry(HD_WIDTH, HD_HEIGHT, HD_WIDTH*2 + 128);
+	bad += check_geometry(352, 288, 352*2);
+	bad += check_geometry(176, 146, 176*2 + 32);
+	bad += check_latency();
+	if(bad)
+		return(1);
+
+	/*
+	** golden output on random and edge frames, odd half sizes that
+	** leave simd tails, padded lines and an odd height for the
+	** conversion kernels
+	*/
+	for(i=0; i<NGOLDEN; i++){
+		for(j=0; j<NFRAMES; j++)
+			bad += check_golden(golden[i].width, golden[i].height, 
+					    golden[i].stride, j);
+	}/*eo for*/
+	fprintf(info, "golden %ld kernel runs differ from yuv422_to_rgb565 / "
+		"haar4.c HaarDwt\n", bad);
+	if(bad || golden_only){
+		close_fb(&fb);
+		return(bad != 0);
+	}/*eo if*/
+
+	/*
+	** direct output into a framebuffer with stride and offsets
+	*/
+	init_simd();
+	memcpy(rgb565, ref, RGB565_SIZE);
+	if(check_direct(yuyv, rgb565, ref_dwt) != 0)
+		return(1);
+	if(check_flip(ref_dwt) != 0)
+		return(1);
+	if(check_blit() != 0)
+		return(1);
+	if(check_scale() != 0)
+		return(1);
+	if(check_compose() != 0)
+		return(1);
+	if(check_osd() != 0)
+		return(1);
+
+	free(yuyv);
+	free(rgb565);
+	free(dwt);
+	free(ref);
+	free(ref_dwt);
+	free(planes);
+	yuyv = rgb565 = dwt = NULL;
+	planes = NULL;
+
+	/*
+	** benchmark every kernel at every size, convert5+HaarDwt uses the 
+	** widest simd kernel
+	*/
+	if(perf_open() < 0)
+		fprintf(info, "perf counters not available\n");
+	for(i=0; i<nsizes; i++){
+		if(bench_size(width[i], height[i]) < 0)
+			return(1);
+		if(format == FMT_TEXT) printf("\n");
+	}/*eo for*/
+
+	/*
+	** HaarDwt2 speedup over one thread of the same kernel and over
+	** the scalar single thread kernel
+	*/
+	fprintf(info, "%-9s %-8s %3s %10s %8s %8s\n", "frame", "simd", "thr", 
+		"ms/frame", "x1 thr", "x scalar");
+	bad = bench_haar2(WQVGA_WIDTH, WQVGA_HEIGHT);
+	bad += bench_haar2(512, 512);
+	bad += bench_haar2(1920, 1080);
+	init_simd();
+
+	/*
+	** lifting round trip of a frame at the camera sizes against the
+	** frame budget
+	*/
+	fprintf(info, "\n%-9s %3s %10s %10s %10s %8s\n", "frame", "thr", 
+		"forward", "inverse", "ms/frame", "budget");
+	bad += bench_lift(WQVGA_WIDTH, WQVGA_HEIGHT);
+	bad += bench_lift(HD_WIDTH, HD_HEIGHT);
+	perf_close();
+
+	/*
+	** framebuffer write bandwidth of the blit engine, the fake one and
+	** /dev/fb0 where there is one to open
+	*/
+	fprintf(info, "\n%-9s %-8s %-9s %10s %10s\n", "blit", "copy", "screen",
+		"ms/frame", "MB/s");
+	bench_blit("file");
+	close_fb(&fb);
+
+	/*
+	** scaled display of the camera frames on the lcd and a wuxga panel
+	*/
+	fprintf(info, "\n%-9s %-8s %-9s %3s %10s %10s\n", "frame", "scale", 
+		"screen", "thr", "ms/frame", "MB/s");
+	bench_scale(WQVGA_WIDTH, WQVGA_HEIGHT);
+	bench_scale(HD_WIDTH, HD_HEIGHT);
+	if(access("/dev/fb0", W_OK) == 0 && fb_open_device("/dev/fb0") == 0){
+		bench_blit("/dev/fb0");
+		munmap(fbp, screensize);
+		close(fb_fd);
+		fbp = NULL;
+	}else{
+		fprintf(info, "%-9s not available\n", "/dev/fb0");
+	}/*eo if*/
+	if(format == FMT_JSON)
+		printf("%s]\n", nresults ? "" : "[");
+	if(bad)
+		return(1);
+
+	return(0);
+
+}/*eo main*/
@@ -4,10 +4,24 @@
 ** write table to disk file
 **
 ** february 10, 2018 - rlg
+**
+** compile using: gcc -O3 lut.c -o lut -lpthread
+**
+** usage: lut [-o path] [-p rgb|bgr] [-t threads]
+**	-o path		output file (default yuv2rgb.lut)
+**	-p order	pixel order of the table entries: bgr = bgr565 as
+**			the beaglebone black lcd and sv5 use it (default),
+**			rgb = rgb565 as used on x86
+**	-t threads	generator threads (default one per online cpu)
+**
+** the file is a struct lut_header (sv5.h) padded to LUT_OFFSET bytes
+** followed by the 256*256*256 entry table indexed by Y<<16 | U<<8 | V.
+** sv5 checks the header and the checksum before it uses the table.
 */
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <sys/mman.h>
 #include <string.h>
 #include <sys/types.h>
@@ -15,81 +29,139 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
+#include "sv5.h"
 
 #define Y_SIZE 256
 #define U_SIZE 256
 #define V_SIZE 256
 
+#define MAX_THREADS 64
+
 uint16_t yuv422_to_rgb565(uint8_t Y, uint8_t U, uint8_t V);
 
-int main(void){
-	uint8_t y=0,u=0,v=0;
-	int i,j,k;
-	long count=0;
-	uint16_t pixel;
-	int err=0;
-	int fd=0;
-	int size = 256*256*256*2;
-	
-	fd = open("/home/rgregg/Desktop/yuv2rgb.lut", O_RDWR | O_CREAT | O_TRUNC, (mode_t)0600);
+/*
+** table pixel order and the slice of Y values each thread fills
+*/
+int order = LUT_BGR565;
+int nthreads = 0;
+uint16_t *table = NULL;
+
+void *lut_thread(void *arg){
+
+	long n = (long)arg;
+	int i=0, j=0, k=0;
+	uint16_t *pb=NULL;
+
+	for(i=n*Y_SIZE/nthreads; i<(n+1)*Y_SIZE/nthreads; i++){
+		pb = table + (i << 16);
+		for(j=0; j<U_SIZE; j++){
+			for(k=0; k<V_SIZE; k++){
+				*pb = yuv422_to_rgb565(i,j,k);
+				pb++;
+			}/*eo for*/
+		}/*eo for*/
+	}/*eo for*/
+
+	return(NULL);
+
+}/*eo lut_thread*/
+
+int main(int argc, char *argv[]){
+
+	char *path = "yuv2rgb.lut";
+	pthread_t tid[MAX_THREADS];
+	struct lut_header *hdr=NULL;
+	uint64_t checksum=0;
+	int opt=0, fd=0;
+	long i=0;
+	long size = LUT_OFFSET + LUT_ENTRIES*2;
+
+	while((opt = getopt(argc, argv, "o:p:t:")) != -1){
+		switch(opt){
+		case 'o':
+			path = optarg;
+			break;
+		case 'p':
+			if(strcmp(optarg, "rgb") == 0) order = LUT_RGB565;
+			else if(strcmp(optarg, "bgr") == 0) order = LUT_BGR565;
+			else{
+				printf("unknown pixel order %s\n", optarg);
+				return(1);
+			}/*eo if*/
+			break;
+		case 't':
+			nthreads = atoi(optarg);
+			break;
+		default:
+			printf("usage: %s [-o path] [-p rgb|bgr] [-t threads]\n",
+			       argv[0]);
+			return(1);
+		}/*eo switch*/
+	}/*eo while*/
+
+	if(nthreads < 1)
+		nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+	if(nthreads < 1) nthreads = 1;
+	if(nthreads > MAX_THREADS) nthreads = MAX_THREADS;
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC, (mode_t)0600);
 	if(fd < 0){
-		err = errno;
-		printf("open failed errno=%d\n", errno);
-		return(0);
+		printf("open %s failed errno=%d\n", path, errno);
+		return(1);
 	}/*eo if*/
 
-	if( lseek(fd, size-1, SEEK_SET) < 0){
-		err = errno;
-		printf("lseek failed errno=%d\n", errno);
-		return(0);
+	if(ftruncate(fd, size) < 0){
+		printf("ftruncate failed errno=%d\n", errno);
+		return(1);
 	}/*eo if*/
 
-	if( write(fd, "", 1) < 0){
-		err = errno;
-		printf("lseek failed errno=%d\n", errno);
-		return(0);
-	}/*eo if*/
-	
-	uint16_t *pbuf = mmap(NULL, size, PROT_WRITE, MAP_SHARED,fd,0);
-	if(pbuf == MAP_FAILED){
-		err = errno;
+	hdr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(hdr == MAP_FAILED){
 		printf("mmap failed errno=%d\n", errno);
-		return(0);
+		return(1);
 	}/*eo if*/
+	table = (uint16_t *)((uint8_t *)hdr + LUT_OFFSET);
 
-	
 	/*
-	** create yuv2rgb look up table
+	** create yuv2rgb look up table, every thread fills a band of Y
 	*/
-	uint16_t *pb = pbuf;		 	
-	for(i=0; i<Y_SIZE; i++){
-		y = (uint8_t)i;
-		for(j=0; j<U_SIZE; j++){
-			u = (uint8_t)j;
-			for(k=0; k<V_SIZE; k++){
-				v = (uint8_t)k;
-				count++;
-				pixel  = yuv422_to_rgb565(y,u,v);
-				printf("%ld Y=%d U=%d V=%d RGB=%04x\n",count,y,u,v,pixel);
-				*pb = pixel;
-				pb++;
-			}/*eo for*/
-			
-		}/*eo for*/
-		
+	for(i=0; i<nthreads; i++){
+		if(pthread_create(&tid[i], NULL, lut_thread, (void *)i) != 0){
+			printf("pthread_create failed\n");
+			return(1);
+		}/*eo if*/
 	}/*eo for*/
+	for(i=0; i<nthreads; i++)
+		pthread_join(tid[i], NULL);
+
+	/*
+	** the header goes in last so that an interrupted run leaves a file
+	** sv5 refuses
+	*/
+	memcpy(hdr->magic, LUT_MAGIC, sizeof(hdr->magic));
+	hdr->colorspace = LUT_BT601;
+	hdr->order = order;
+	hdr->entries = LUT_ENTRIES;
+	hdr->checksum = checksum = lut_checksum(table, LUT_ENTRIES);
+	hdr->version = LUT_VERSION;
 
 	/*
 	** write yuv2rgb look up table to disk
 	*/
-	msync(pbuf, size, MS_SYNC);
+	if(msync(hdr, size, MS_SYNC) < 0){
+		printf("msync failed errno=%d\n", errno);
+		return(1);
+	}/*eo if*/
 
 	/*
 	** clean up
 	*/
+	munmap(hdr, size);
 	close(fd);
-	munmap(pbuf,(size));
-	printf("done\n");
+	printf("%s: %d entries %s565 checksum %016llx, %d threads\n", path,
+	       LUT_ENTRIES, order == LUT_RGB565 ? "rgb" : "bgr",
+	       (unsigned long long)checksum, nthreads);
 
 	return(0);
 
@@ -116,7 +188,7 @@ uint16_t yuv422_to_rgb565(uint8_t Y, uint8_t U, uint8_t V){
 	if(g<0) g=0;
 	if(g>255) g=255;
 	green = (uint8_t)g;
-	
+
 	b = 1.164*(float)(Y-16) + 2.018*(float)(U-128);
 	if(b<0) b=0;
 	if(b>255) b=255;
@@ -125,17 +197,19 @@ uint16_t yuv422_to_rgb565(uint8_t Y, uint8_t U, uint8_t V){
 	/*
 	** rgb565 format used in x86
 	*/
-	/*
-	r16 = ((red >>3) & 0x1f) << 11;	
-	g16 = ((green >> 2) & 0x3f) << 5;
-	b16 = (blue >> 3) & 0x1f;
-	rgb565 = r16 | g16 | b16;
-	*/
-	
+	if(order == LUT_RGB565){
+		r16 = ((red >>3) & 0x1f) << 11;
+		g16 = ((green >> 2) & 0x3f) << 5;
+		b16 = (blue >> 3) & 0x1f;
+		rgb565 = r16 | g16 | b16;
+
+		return(rgb565);
+	}/*eo if*/
+
 	/*
 	** bgr565 format used in ARM & Beaglebone Black
 	*/
-	b16 = ((blue >>3) & 0x1f) << 11;	
+	b16 = ((blue >>3) & 0x1f) << 11;
 	g16 = ((green >> 2) & 0x3f) << 5;
 	r16 = (red >> 3) & 0x1f;
 	bgr565 = b16 | g16 | r16;
@@ -143,10 +217,3 @@ uint16_t yuv422_to_rgb565(uint8_t Y, uint8_t U, uint8_t V){
 	return(bgr565);
 
 }/*eo yuv422_to_rgb888*/
-
-
-
-
-
-
-
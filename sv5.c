@@ -10,8 +10,93 @@
 ** NOTE: need to run as root in tty1 (chvt 1) because framebuffer is at
 ** the linux kernel level and only available in tty
 **
-** DEBUG compile using: gcc -g3 sv5.c -o sv5 -lrt
-** OPTIMIZE compile using: gcc -O3 sv5.c -o sv5 -lrt
+** DEBUG compile using: gcc -g3 sv5.c -o sv5 -lrt -lpthread -lm
+** OPTIMIZE compile using: gcc -O3 sv5.c -o sv5 -lrt -lpthread -lm
+** on beaglebone black (armhf) the neon kernels need the fpu flags:
+**	gcc -O3 -mfpu=neon -mfloat-abi=hard sv5.c -o sv5 -lrt -lpthread -lm
+**
+** usage: sv5 [-b] [-c convert] [-d threshold[,hard|soft]] [-f] [-D] 
+**	     [-F file[,w,h,line_length]] [-g] [-H] [-n nbufs] [-N frames] 
+**	     [-l] [-O] [-p] [-r fps] [-S source] [-s WxH] [-t threads] [-v]
+**	     [-V layout[,band]] [-w] [-z nearest|bilinear[,stretch]]
+**	-b		double buffered: the framebuffer gets a second page
+**			(yres_virtual = 2 x yres), frames are drawn into the
+**			hidden page and shown with FBIOPAN_DISPLAY. the time
+**			a flip takes is reported as flip->vsync. with -D 
+**			only in the serial loop (not with -p)
+**	-c convert	yuv422 to rgb565 conversion: 2 = floating point, 
+**			3 = /home/root/yuv2rgb.lut look up table made by lut,
+**			4 = compact cache resident tables built into the
+**			binary (default),
+**			5 = simd fixed point (neon, sse2 or avx2 picked at
+**			run time, SV5_ISA=scalar|sse2|avx2|neon overrides)
+**	-d threshold	wavelet denoise: the rgb565 frame goes through three
+**			levels of haar lifting, the detail coefficients are
+**			soft (default) or hard thresholded as they are made
+**			and the inverse transform gives the displayed frame
+**			(-f and -D do not apply). the threshold is in 6 bit
+**			green steps (0..1023), half of it rounded up is used
+**			for red and blue.
+**			keys on stdin while streaming: + and - change the
+**			threshold, s and h pick soft or hard thresholding
+**	-f		fused: haar dwt straight from the yuyv422 capture
+**			buffer, no intermediate rgb565 frame
+**	-D		direct: the haar dwt writes its pixels straight into 
+**			the centred area of the framebuffer mapping
+**	-F file		use a regular file as a fake framebuffer (default
+**			480x272, line length 960 bytes) instead of /dev/fb0.
+**			frames are copied into /dev/fb0 row by row with 
+**			streaming stores where the cpu has them and into a 
+**			file with memcpy (SV5_BLIT=memcpy|stream overrides)
+**	-g		grayscale: only the luma is taken from the capture
+**			buffer, the haar dwt runs on one 8 bit channel and
+**			the result is shown in grey (-c, -d, -f, -D and -t
+**			do not apply)
+**	-H		copy the yuv2rgb.lut table into huge pages (the
+**			MAP_HUGETLB pool, else transparent huge pages) and
+**			mlock it, the page size and the dTLB misses per
+**			frame are reported at the end (-c 3 only)
+**	-n nbufs	number of v4l2 capture buffers in the ring (default 4)
+**	-N frames	number of timed frames (default 100)
+**	-l		latest frame wins: non-blocking capture, stale frames
+**			are requeued without being processed
+**	-O		telemetry overlay in the top left corner: frame rate,
+**			dropped frames, end-to-end and per stage ms. only the
+**			glyph cells that changed or that the video wrote over
+**			are drawn, within OSD_BUDGET_US per frame, its cost
+**			is reported at the end
+**	-p		pipelined: capture, process and display run in their
+**			own threads joined by lock-free queues, a stage with
+**			nothing to do sleeps on a futex
+**	-r fps		pace the file and synth sources to fps, late frames
+**			are dropped with -l (default 0 = as fast as possible)
+**	-S source	capture source: v4l2[:device] (default /dev/video0),
+**			file:path (raw frames of -s size as the webcam
+**			delivers them, replayed in a loop) or synth (moving
+**			test pattern). with -F the whole pipeline runs
+**			without a webcam or display
+**	-s WxH		webcam frame size (default 432x240), the driver may
+**			pick the nearest size it supports. 432x240, 640x480
+**			and 1280x720 run size specialized kernels
+**	-t threads	simd haar dwt split into row bands over a pool of
+**			threads (1..16, the caller is one of them)
+**	-v		print the number of buffers in flight for every frame
+**	-V layout	views of the frame laid out in the framebuffer: dwt
+**			(default), raw (the rgb565 frame), split (raw left,
+**			dwt right) or zoom (one dwt subband, ll, lh, hl or 
+**			hh after the comma, filling the screen). views that
+**			do not fit are scaled as -z (nearest without it).
+**			keys on stdin while streaming: 1..4 pick the layout,
+**			v the next one, b the next zoomed subband. with -d 
+**			the dwt view is the denoised frame (-f and -D do not
+**			apply)
+**	-w		wait for the vertical blank after every flip 
+**			(FBIO_WAITFORVSYNC), implies -b
+**	-z mode		scale the frame to fill the framebuffer, nearest or
+**			bilinear (fixed point, simd as -c 5). the aspect 
+**			ratio is kept unless ,stretch is given. the scaled
+**			rows go straight into the framebuffer, split over 
+**			the -t threads (-g and -D do not apply)
 **
 ** set cpu frequency governor to "performance" on start-up
 ** echo userspace > /sys/devices/system/cpu/cpu0/cpufreq/scaling_governor
@@ -25,79 +110,169 @@
 #include <sys/ioctl.h>
 #include <stdlib.h>
 #include <time.h>
+#include <math.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <stdarg.h>
+#include <poll.h>
+#include <termios.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <linux/videodev2.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_ARM_NEON
+#define HWCAP_ARM_NEON	(1 << 12)	/*HWCAP_NEON of <asm/hwcap.h>*/
+#endif
+#endif
+#include "sv5.h"
 
 /*
-** 4D LCD display resolution 480 x 272
-** HVGA (Half-size VGA) screens have 480×320 pixels (3:2 aspect ratio), 
-** 480×360 pixels (4:3 aspect ratio), 480×272 (~16:9 aspect ratio) 
-** or 640×240 pixels (8:3 aspect ** ratio). 
+** benchmark timing sample size
 */
-#define	HVGA_WIDTH	480
-#define HVGA_HEIGHT	272 
-#define FRAMEBUF_SIZE	HVGA_WIDTH*HVGA_HEIGHT*2
+#define SAMPLE_SIZE	100
 /*
-** WQVGA resolution is 432 x 240
-** Logitech c920 USB Camera
+** maximum number of v4l2 capture buffers in the ring
 */
-#define	WQVGA_WIDTH	432
-#define WQVGA_HEIGHT	240
-#define FILEBUF_SIZE	WQVGA_WIDTH*WQVGA_HEIGHT*2
-#define RGB565_SIZE 	WQVGA_WIDTH*WQVGA_HEIGHT*2
-#define RGB888_SIZE 	WQVGA_WIDTH*WQVGA_HEIGHT*3
-#define YUYV_SIZE   	WQVGA_WIDTH*WQVGA_HEIGHT*2
-#define GRAYSCALE_SIZE	WQVGA_WIDTH*WQVGA_HEIGHT
+#define MAX_CAPBUFS	32
 /*
-** SVGA resolution is 800 x 600
+** poll() timeout waiting for a filled capture buffer
 */
-#define SVGA_WIDTH	800
-#define SVGA_HEIGHT	600
+#define CAPTURE_TIMEOUT_MS	2000
 /*
-** WUXGA resolution is 1920 x 1200
+** frames pre-rendered by the synthetic capture source
 */
-#define WUXGA_WIDTH	1920
-#define WUXGA_HEIGHT	1200
+#define SYNTH_FRAMES	16
 /*
-** benchmark timing sample size
+** pipelined mode: preallocated frames in flight between the stages and
+** size of the single-producer/single-consumer queues (power of 2)
 */
-#define SAMPLE_SIZE	100
+#define PIPE_FRAMES	4
+#define SPSC_SIZE	8
 /*
-** RGB565
+** an idle stage polls its queue SPSC_SPIN times (with more than one
+** cpu), then sleeps on the queue futex for at most PIPE_WAIT_MS
 */
-#define WHITE	0xffff
-#define YELLOW	0xffe0
-#define CYAN	0x07ff
-#define GREEN	0x07e0
-#define MAGENTA	0xf81f
-#define RED	0xf800
-#define BLUE	0x001f
-#define BLACK	0x0000
-#define GRAY	0xc618
+#define SPSC_SPIN	200
+#define PIPE_WAIT_MS	100
 /*
-** function declarations
+** per frame CLOCK_MONOTONIC timestamps (ns): driver capture
+** (v4l2_buf.timestamp), dequeue, convert done, dwt done, display done
+*/
+enum {
+	STAMP_CAPTURE, STAMP_DEQUEUE, STAMP_CONVERT, STAMP_DWT, STAMP_DISPLAY,
+	NSTAMPS
+};
+/*
+** latency histograms (sv5.h), one per stage plus end-to-end
+*/
+#define LAT_TOTAL	(NSTAMPS-1)
+/*
+** compile-time specialized frame sizes
+** calls fn(width, height, ...) with constant sizes for the common webcam
+** modes, so the always inlined kernel is built with fixed loop bounds
+** and quadrant offsets, and with the run-time geometry for the rest
+*/
+#define GEO_SPECIALIZE(g, fn, ...) do{ \
+	if((g)->width == WQVGA_WIDTH && (g)->height == WQVGA_HEIGHT) \
+		fn(WQVGA_WIDTH, WQVGA_HEIGHT, __VA_ARGS__); \
+	else if((g)->width == VGA_WIDTH && (g)->height == VGA_HEIGHT) \
+		fn(VGA_WIDTH, VGA_HEIGHT, __VA_ARGS__); \
+	else if((g)->width == HD_WIDTH && (g)->height == HD_HEIGHT) \
+		fn(HD_WIDTH, HD_HEIGHT, __VA_ARGS__); \
+	else \
+		fn((g)->width, (g)->height, __VA_ARGS__); \
+}while(0)
+/*
+** a frame travelling through the capture, process and display stages
+*/
+struct frame {
+	int index;		/*v4l2 buffer index*/
+	void *yuyv;		/*captured yuyv422 frame (v4l2 buffer)*/
+	uint8_t *rgb565;	/*converted rgb565 frame, 8 bit luma with -g*/
+	uint16_t *dwt;		/*haar dwt rgb565 frame, 8 bit with -g*/
+	int64_t stamp[NSTAMPS];	/*CLOCK_MONOTONIC ns, STAMP_* */
+};
+
+/*
+** capture source
+** open sets cap_geo and nbufs and prepares the buffers cap_buf[], start
+** starts streaming, next returns the index, flags and timestamp of the
+** next filled buffer like VIDIOC_DQBUF, release hands a buffer back to
+** be filled again and close stops streaming and frees the buffers.
+*/
+struct capture_source {
+	char *name;
+	int (*open)(char *arg);
+	int (*start)(void);
+	int (*next)(struct v4l2_buffer *buf);
+	int (*release)(int index);
+	void (*close)(void);
+};
+
+/*
+** lock-free single-producer/single-consumer ring of frame pointers
+** head is only written by the producer, tail only by the consumer.
+** the consumer samples the queue depth on every pop (occupancy).
+** a consumer about to sleep sets waiting, the producer then bumps seq
+** (the futex word) and wakes it.
 */
-uint16_t rgb888_to_rgb565(uint32_t);
-uint32_t yuv422_to_rgb888(uint8_t Y, uint8_t U, uint8_t V);
-uint16_t yuv422_to_rgb565(uint8_t Y, uint8_t U, uint8_t V);
-int display_HDMI(void *fbp, uint8_t *rgb565ptr);
-int display_LCD4(void *fbp, void *filebuf);
-int convert2(void *cbp, uint8_t *rgb565ptr);
-int convert3(void *cbp, uint8_t *rgb565ptr, uint16_t *pbuf);
-int RGBColorBars_HDMI(void *fbp);
-int RGBColorBars_LCD4(void *fbp);
-int RGBDisplayFile_HDMI(void *fbp, char *filepath);
-int ReadRGBFile(void *filebuf, char *fpath);
-int WriteRGBFile(void *filebuf, char *fpath);
-int init_fb_color(void *fbp, uint16_t color);
+struct spsc_queue {
+	_Atomic unsigned int head;
+	char pad1[60];
+	_Atomic unsigned int tail;
+	char pad2[60];
+	struct frame *slot[SPSC_SIZE];
+	long occ_sum, occ_samples;
+	unsigned int occ_max;
+	_Atomic int seq;
+	_Atomic int waiting;
+};
 
 /*
-** haar dwt constants and function declaration
+** function declarations
 */
-int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr);
+int lut_load(char *path);
+int lut_hugepages(void);
+void lut_report(FILE *fp);
+int capture_map_buffers(int fd, int nbufs);
+int capture_queue(int fd, int index);
+void capture_unmap_buffers(int nbufs);
+int capture_dequeue_latest(int fd, struct v4l2_buffer *latest);
+int capture_next(struct v4l2_buffer *buf);
+int capture_open(char *spec);
+int capture_release(int index);
+int process_frame(struct frame *f);
+int display_frame(struct frame *f);
+int spsc_push(struct spsc_queue *q, struct frame *f);
+void futex_wait(_Atomic int *addr, int val, int ms);
+void futex_wake(_Atomic int *addr);
+struct frame *spsc_pop(struct spsc_queue *q);
+int run_pipeline(int nframes);
+void frame_stamp(struct frame *f, int stamp);
+void frame_capture_stamps(struct frame *f, struct v4l2_buffer *buf);
+void latency_record(struct frame *f);
+void latency_report(void);
+int keys_open(void);
+int keys_poll(void);
+void keys_close(void);
+int denoise_parse(char *spec);
+int scale_parse(char *spec);
+int view_parse(char *spec);
+void display_keys(void);
+void osd_frame(void);
+void osd_stats(struct frame *f);
 
 /*
 ** general purpose variables
@@ -121,11 +296,135 @@ int fb_fd=0;
 uint16_t *fbp=NULL;
 void *filebuf=NULL;
 
+/*
+** frame geometry
+** cap_geo is the webcam format read back with VIDIOC_G_FMT (the default
+** is the c920 WQVGA mode), fb_geo the visible framebuffer area read with
+** FBIOGET_VSCREENINFO/FSCREENINFO. every kernel works on cap_geo frames.
+*/
+struct geometry cap_geo = {
+	WQVGA_WIDTH, WQVGA_HEIGHT, WQVGA_WIDTH*2, V4L2_PIX_FMT_YUYV
+};
+struct geometry fb_geo = {
+	HVGA_WIDTH, HVGA_HEIGHT, HVGA_WIDTH*2, V4L2_PIX_FMT_RGB565
+};
+
+/*
+** direct to framebuffer output
+** fb_dst is the first pixel of the centred frame inside the visible
+** framebuffer area, fb_stride the framebuffer line length in pixels
+*/
+int direct = 0;
+char *fakefb = NULL;
+uint16_t *fb_dst = NULL;
+int fb_stride = 0;
+
+/*
+** double buffering (-b, -w)
+** the virtual framebuffer is two pages high. frames are drawn into the
+** page starting at line fb_back and shown by panning to it, with -w the
+** flip also waits for the vertical blank. fb_file is set for a regular
+** file standing in for the framebuffer, it is panned without an ioctl.
+*/
+int dbuf = 0;
+int vsync = 0;
+unsigned int fb_back = 0;
+int fb_file = 0;
+struct latency_hist flip_latency = { .name = "flip->vsync" };
+
 /*
 ** yuv422 to rgb565 look up table (lut) variables
 */
 int lut_size = 256*256*256*2;
 int lut_fd=0;
+struct lut_header *lut_hdr=NULL;	/*file mapping, the table follows*/
+uint16_t *lut_ptr=NULL;
+int lut_huge = 0;		/*table copied into locked huge pages*/
+void *lut_map = NULL;		/*huge page mapping of the table*/
+size_t lut_map_size = 0;
+char *lut_mode = "MAP_POPULATE file mapping";
+int convert = 4;
+int fused = 0;
+int gray = 0;		/*luma only, 8 bit haar dwt shown in grey*/
+int threads = 0;	/*HaarDwt2 pool size, 0 = scalar HaarDwt*/
+
+/*
+** wavelet denoise (-d)
+** the threshold and mode are changed by keys on stdin while the process
+** stage reads them once per frame. denoise_planes holds the three int16
+** planes of the frame being denoised.
+*/
+int denoise = 0;
+_Atomic int denoise_thresh = 0;
+_Atomic int denoise_soft = 1;
+int16_t *denoise_planes = NULL;
+
+/*
+** scaled display (-z)
+** scale is SCALE_NEAREST or SCALE_BILINEAR, 0 shows the frame at its
+** own size. the scaled size keeps the aspect ratio unless stretched.
+*/
+int scale = 0;
+int scale_stretch = 0;
+
+/*
+** views (-V)
+** the layout and zoomed subband are set by keys in the display stage,
+** comp is rebuilt from them when they change
+*/
+int views = 0;
+int view_layout = VIEW_DWT;
+int view_band = 0;
+int comp_clear = 0;	/*pages still to clear for a new layout*/
+struct compositor comp;
+
+/*
+** telemetry overlay (-O)
+** drawn by the display stage, the text is refreshed every 
+** OSD_REFRESH_MS so it can be read
+*/
+#define OSD_REFRESH_MS	250
+int osd = 0;
+struct latency_hist osd_latency = { .name = "overlay" };
+
+/*
+** keys on stdin, a terminal is switched to unbuffered input without echo
+** and restored at exit
+*/
+int keys_fd = -1;
+int keys_tty = 0;
+struct termios keys_termios;
+
+/*
+** compact yuv422 to rgb565 tables used by convert4()
+** generated by the compiler, see TAB_256 below, and linked into .rodata
+*/
+#define TAB_ROUND(v)	((int32_t)((v) < 0 ? (v) - 0.5 : (v) + 0.5))
+#define TAB_Y(i)	(TAB_ROUND(1.164*((i)-16)*65536.0) + 8)
+#define TAB_RV(i)	TAB_ROUND(1.596*((i)-128)*65536.0)
+#define TAB_GU(i)	TAB_ROUND(-0.391*((i)-128)*65536.0)
+#define TAB_GV(i)	TAB_ROUND(-0.813*((i)-128)*65536.0)
+#define TAB_BU(i)	TAB_ROUND(2.018*((i)-128)*65536.0)
+#define TAB_CLAMP(i)	((i)+TAB_CLAMP_MIN < 0 ? 0 : \
+			 (i)+TAB_CLAMP_MIN > 255 ? 255 : (i)+TAB_CLAMP_MIN)
+
+#define TAB_4(f, i)	f(i), f((i)+1), f((i)+2), f((i)+3)
+#define TAB_16(f, i)	TAB_4(f, i), TAB_4(f, (i)+4), TAB_4(f, (i)+8), \
+			TAB_4(f, (i)+12)
+#define TAB_64(f, i)	TAB_16(f, i), TAB_16(f, (i)+16), TAB_16(f, (i)+32), \
+			TAB_16(f, (i)+48)
+#define TAB_256(f, i)	TAB_64(f, i), TAB_64(f, (i)+64), TAB_64(f, (i)+128), \
+			TAB_64(f, (i)+192)
+
+const int32_t tab_y[256] = { TAB_256(TAB_Y, 0) };
+const int32_t tab_rv[256] = { TAB_256(TAB_RV, 0) };
+const int32_t tab_gu[256] = { TAB_256(TAB_GU, 0) };
+const int32_t tab_gv[256] = { TAB_256(TAB_GV, 0) };
+const int32_t tab_bu[256] = { TAB_256(TAB_BU, 0) };
+const uint8_t tab_clamp[TAB_CLAMP_SIZE] = {	/*832 = 3*256 + 64*/
+	TAB_256(TAB_CLAMP, 0), TAB_256(TAB_CLAMP, 256), 
+	TAB_256(TAB_CLAMP, 512), TAB_64(TAB_CLAMP, 768)
+};
 
 /*
 ** webcam video for linux (v4l2) variables
@@ -137,6 +436,50 @@ struct v4l2_requestbuffers v4l2_reqbuf;
 struct v4l2_buffer v4l2_buf;
 void *cbp = NULL;
 
+/*
+** capture source, picked with -S
+*/
+struct capture_source *source = NULL;
+char *capspec = "v4l2";
+double source_fps = 0;
+
+/*
+** v4l2 capture buffer ring
+** every buffer returned by VIDIOC_REQBUFS is mapped and kept queued to the
+** driver while earlier frames are processed. cap_queued counts the buffers
+** currently owned by the driver (in flight).
+*/
+int nbufs = 4;
+void *cap_buf[MAX_CAPBUFS];
+size_t cap_len[MAX_CAPBUFS];
+_Atomic int cap_queued = 0;
+long inflight_hist[MAX_CAPBUFS+1];
+long inflight_sum = 0, inflight_samples = 0;
+int inflight_min = MAX_CAPBUFS, inflight_max = 0;
+int verbose = 0;
+
+/*
+** latest frame wins capture
+** in this mode the webcam is opened O_NONBLOCK and every ready buffer is
+** drained each frame; only the newest one is processed.
+*/
+int latest = 0;
+long frames_processed = 0;		/*display stage, frames shown*/
+_Atomic long frames_dropped = 0;	/*capture stage, read by the overlay*/
+
+/*
+** pipelined mode
+** free_q returns displayed frames to the capture stage, cap_q carries
+** captured frames to the process stage and proc_q carries processed
+** frames to the display stage. busy time is accumulated per stage.
+** idle stages sleep, spsc_spin is 0 on a single cpu.
+*/
+int pipeline = 0;
+struct spsc_queue free_q, cap_q, proc_q;
+_Atomic int pipe_stop = 0;
+int spsc_spin = 0;
+double stage_busy[3];
+
 /*
 ** timing declarations
 */
@@ -145,210 +488,295 @@ struct timespec fps_start_time,
 		init_time_start, 
 		init_time_end; 
 double t_diff=0, fps=0;
+int nframes=SAMPLE_SIZE;	/*timed frames, -N*/
 int count=SAMPLE_SIZE;
 int tlog=1;	/*1=timing on, 0=timing off*/
 
+/*
+** per stage latency, the stage time is measured from the previous
+** timestamp so time spent waiting in a pipeline queue is charged to the
+** stage that dequeues the frame
+*/
+struct latency_hist latency[NSTAMPS] = {
+	{ .name = "driver->dequeue" }, { .name = "convert" }, 
+	{ .name = "haar dwt" }, { .name = "display" }, 
+	{ .name = "end-to-end" }
+};
+long driver_stamps = 0;	/*frames with a monotonic v4l2 timestamp*/
+
 /***************************************
 ** main()
 ***************************************/
 
-int main(void)
+#ifndef SV5_NO_MAIN
+int main(int argc, char *argv[])
 {
-	if (tlog) clock_gettime(CLOCK_REALTIME, &init_time_start);
-	
-	/*
-	** open the framebuffer
-	*/
-	
-	if((fb_fd = open("/dev/fb0",O_RDWR))<0)
-	{
-		perror("open\n");
-		exit(1);
-	}/*eo if*/
-	
-	/*
-	** Initialize the framebuffer
-	*/
-	ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo);
-	vinfo.grayscale=0;
-	vinfo.bits_per_pixel=16;
-	if (ioctl(fb_fd, FBIOPUT_VSCREENINFO, &vinfo) < 0){
-		printf("FBIOPUT_VSCREENINFO error %d\n", errno);
-		exit(1);
-	}/*eo if*/
+	int opt;
+	long long perf_val[NPERF];
+	int nperf=0;
 
-	/*
-	** get the framebuffer properties
-	*/
-	ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo);	
-	ioctl(fb_fd, FBIOGET_FSCREENINFO, &finfo);	
+	if (tlog) clock_gettime(CLOCK_MONOTONIC, &init_time_start);
 
 	/*
-	** calculate the framebuffer screensize
+	** command line options
 	*/
-	screensize = vinfo.yres_virtual * finfo.line_length;
+	while((opt = getopt(argc, argv, "bc:d:fDF:gHn:N:lOpr:S:s:t:vV:wz:")) != -1){
+		switch(opt){
+		case 'b':
+			dbuf = 1;
+			break;
+		case 'c':
+			convert = atoi(optarg);
+			if(convert < 2 || convert > 5){
+				fprintf(stderr, "convert must be 2, 3, 4 or 5\n");
+				exit(1);
+			}/*eo if*/
+			break;
+		case 'd':
+			if(denoise_parse(optarg) < 0){
+				fprintf(stderr, "denoise must be threshold"
+					"[,hard|soft], threshold 0..%d\n", 
+					DENOISE_MAX_THRESH);
+				exit(1);
+			}/*eo if*/
+			break;
+		case 'f':
+			fused = 1;
+			break;
+		case 'D':
+			direct = 1;
+			break;
+		case 'F':
+			fakefb = optarg;
+			break;
+		case 'g':
+			gray = 1;
+			break;
+		case 'H':
+			lut_huge = 1;
+			break;
+		case 'n':
+			nbufs = atoi(optarg);
+			if(nbufs < 1 || nbufs > MAX_CAPBUFS){
+				fprintf(stderr, "nbufs must be 1..%d\n", MAX_CAPBUFS);
+				exit(1);
+			}/*eo if*/
+			break;
+		case 'N':
+			nframes = count = atoi(optarg);
+			if(nframes < 1){
+				fprintf(stderr, "frames must be at least 1\n");
+				exit(1);
+			}/*eo if*/
+			break;
+		case 'l':
+			latest = 1;
+			break;
+		case 'O':
+			osd = 1;
+			break;
+		case 'r':
+			source_fps = atof(optarg);
+			break;
+		case 'S':
+			capspec = optarg;
+			break;
+		case 'p':
+			pipeline = 1;
+			break;
+		case 's':
+			if(sscanf(optarg, "%dx%d", &cap_geo.width, 
+				  &cap_geo.height) != 2 || cap_geo.width < 2 ||
+			   cap_geo.height < 2 || cap_geo.width%2 || 
+			   cap_geo.height%2 || cap_geo.width > MAX_FRAME_WIDTH){
+				fprintf(stderr, "size must be WxH, even, W up to "
+					"%d\n", MAX_FRAME_WIDTH);
+				exit(1);
+			}/*eo if*/
+			break;
+		case 't':
+			threads = atoi(optarg);
+			if(threads < 1 || threads > 16){
+				fprintf(stderr, "threads must be 1..16\n");
+				exit(1);
+			}/*eo if*/
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		case 'V':
+			if(view_parse(optarg) < 0){
+				fprintf(stderr, "view must be dwt|raw|split|zoom"
+					"[,ll|lh|hl|hh]\n");
+				exit(1);
+			}/*eo if*/
+			break;
+		case 'w':
+			dbuf = vsync = 1;
+			break;
+		case 'z':
+			if(scale_parse(optarg) < 0){
+				fprintf(stderr, "scale must be nearest|bilinear"
+					"[,stretch]\n");
+				exit(1);
+			}/*eo if*/
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-b] [-c convert] "
+				"[-d threshold[,hard|soft]] [-f] [-D] "
+				"[-F file[,w,h,line_length]] [-g] [-H] [-n nbufs] "
+				"[-N frames] [-l] [-O] [-p] [-r fps] [-S source] "
+				"[-s WxH] [-t threads] [-v] [-V layout[,band]] "
+				"[-w] [-z nearest|bilinear[,stretch]]\n", argv[0]);
+			exit(1);
+		}/*eo switch*/
+	}/*eo while*/
 
 	/*
-	** get the address for the framebuffer
+	** the denoised frame is rebuilt from the rgb565 frame and shown 
+	** through the display stage
 	*/
-	fbp = NULL;
-	fbp = mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED, fb_fd, 0);
-	if (fbp == MAP_FAILED){
-		printf("framebuffer - mmap failed errno %d\n", errno);
-		exit(1);
-	}/*eo if*/
+	if(denoise)
+		fused = direct = 0;
 
 	/*
-	** set up camera
+	** scaled frames and views are made on the way into the 
+	** framebuffer, there is no frame of that size for -D to write and
+	** the raw view needs the rgb565 frame. grey frames are shown at
+	** their own size.
 	*/
+	if(gray)
+		scale = views = 0;
+	if(scale)
+		direct = 0;
+	if(views)
+		fused = direct = 0;
 
 	/*
-	** open webcam
-	** video0 = Logitech C920 USB Webcam on Beagle Bone Black
+	** a pipelined direct frame would be written while the display stage
+	** flips the pages
 	*/
-	if((vid_fd = open("/dev/video0", O_RDWR )) < 0)
-	{
-		perror("webcam open");
+	if(dbuf && direct && pipeline){
+		fprintf(stderr, "-b with -D needs the serial loop, not -p\n");
 		exit(1);
 	}/*eo if*/
 
 	/*
-	** get webcam capabilites	
+	** only convert3 reads the yuv2rgb.lut table
 	*/
-	if(ioctl(vid_fd, VIDIOC_QUERYCAP, &v4l2_cap) < 0)
-	{
-		perror("VIDIOC_QUERYCAP");
+	if(lut_huge && (convert != 3 || fused || gray)){
+		fprintf(stderr, "-H needs the look up table of -c 3, not -f or "
+			"-g\n");
 		exit(1);
 	}/*eo if*/
-
 	
-	if(!(v4l2_cap.capabilities & V4L2_CAP_VIDEO_CAPTURE))
-	{
-		fprintf(stderr, "The device does not handle single-planar video\n");
-		exit(1);
-	}//eo if
+	if(fakefb){
 
-	
-	if(!(v4l2_cap.capabilities & V4L2_CAP_STREAMING))
-	{
-		fprintf(stderr, "The device does not handle frame streaming\n");
-		exit(1);
-	}//eo if
+		/*
+		** regular file standing in for the framebuffer
+		*/
+		if(fb_open_file(fakefb) < 0)
+			exit(1);
 
-	/*
-	** set the webcam format
-	*/
-	memset(&v4l2_fmt, 0, sizeof(v4l2_fmt));
-	v4l2_fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-	v4l2_fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
-	v4l2_fmt.fmt.pix.width =  WQVGA_WIDTH;	/*432*/	
-	v4l2_fmt.fmt.pix.height = WQVGA_HEIGHT;	/*240*/
+	}else{
+
+		/*
+		** open, initialize and map the framebuffer
+		*/
+		if(fb_open_device("/dev/fb0") < 0)
+			exit(1);
 
-	if(ioctl(vid_fd, VIDIOC_S_FMT, &v4l2_fmt) <0)
-	{
-		perror("VIDIOC_S_FMT");
-		exit(1);
 	}/*eo if*/
 
 	/*
-	** request buffer(s)
-	** initiate memory mapped I/O. Memory mapped buffers are located in device
-	** memory and must be allocated before they can be mapped into the applications
-	** I/O space. 
+	** the first frame goes into the second page
 	*/
-	memset(&v4l2_reqbuf, 0, sizeof(v4l2_reqbuf));
-	v4l2_reqbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-	v4l2_reqbuf.memory = V4L2_MEMORY_MMAP;
-	v4l2_reqbuf.count = 1;
-	
-	if(ioctl(vid_fd, VIDIOC_REQBUFS, &v4l2_reqbuf) < 0)
-	{
-		perror("VIDIOC_REQBUFS");
-		exit(0);
+	if(dbuf && vinfo.yres_virtual < 2*vinfo.yres){
+		printf("framebuffer - no room for a second page, single "
+		       "buffered\n");
+		dbuf = vsync = 0;
 	}/*eo if*/
+	if(dbuf)
+		fb_back = vinfo.yres;
 
 	/*
-	** query the status of the buffers (why?)
+	** visible framebuffer geometry and the row copy the display uses
 	*/
-	memset(&v4l2_buf, 0, sizeof(v4l2_buf));
-	v4l2_buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-	v4l2_buf.memory = V4L2_MEMORY_MMAP;
-	v4l2_buf.index = 0;
-
-	if(ioctl(vid_fd, VIDIOC_QUERYBUF, &v4l2_buf) < 0)
-	{
-		perror("VIDIOC_QUERYBUF");
+	if(fb_geometry() < 0 || init_blit() < 0)
 		exit(1);
-	}/*eo if*/
 
 	/*
-	** map webcam buffer to kernel space
+	** open the capture source, it sets the frame geometry and the
+	** number of capture buffers
 	*/
-	cbp = mmap(NULL, v4l2_buf.length,PROT_READ | PROT_WRITE,
-		   MAP_SHARED, vid_fd, v4l2_buf.m.offset);
-		
-	if(cbp == MAP_FAILED)
-	{
-		printf("camera - mmap failed errno=%d\n", errno);
+	if(capture_open(capspec) < 0)
 		exit(1);
-	}/*eo if*/
 
 	/*
-	** start v4l2 streaming
+	** centred frame inside the visible area, honouring the panning
+	** offsets and the line length of the framebuffer. the display 
+	** routines clip larger frames, direct output needs it to fit
 	*/
-	memset(&v4l2_buf, 0, sizeof(v4l2_buf));
-	v4l2_buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-	v4l2_buf.memory = V4L2_MEMORY_MMAP;
-	v4l2_buf.index = 0;
-
-	int type = v4l2_reqbuf.type;
-	int result = ioctl(vid_fd, VIDIOC_STREAMON, &type);	
-	if(result < 0)
-	{
-		perror("VIDIOC_STREAMON");
-		int error = errno;
+	fb_stride = fb_geo.stride/2;
+	fb_dst = fb_origin(fbp, cap_geo.width, cap_geo.height);
+	if(fb_dst == NULL && direct){
+		fprintf(stderr, "%dx%d frame does not fit the %dx%d framebuffer\n",
+			cap_geo.width, cap_geo.height, fb_geo.width, 
+			fb_geo.height);
 		exit(1);
 	}/*eo if*/
 
 	/*
-	** set up rgb565file buffer
+	** regions and scaler tables of the first layout, -z alone is the
+	** dwt view scaled to the visible area
 	*/
-	orig_rgb565ptr = rgb565ptr = (uint8_t*)malloc(RGB565_SIZE);
-	memset(rgb565ptr, 0, RGB565_SIZE);
+	if(scale || views){
+		if(init_simd() < 0 || compose_layout(&comp, view_layout, 
+		   view_band, scale, scale_stretch) < 0){
+			fprintf(stderr, "cannot lay out %dx%d frames on the "
+				"%dx%d framebuffer\n", cap_geo.width, 
+				cap_geo.height, fb_geo.width, fb_geo.height);
+			exit(1);
+		}/*eo if*/
+	}/*eo if*/
 
 	/*
-	** use yuv2rgb look up table
+	** start streaming
 	*/
-	lut_fd = open("/home/root/yuv2rgb.lut", O_RDWR);
-	if(lut_fd < 0){
-		printf("yuv2rgb.lut open failed errno=%d\n", errno);
-		return(0);
-	}/*eo if*/
+	if(source->start() < 0)
+		exit(1);
 
 	/*
-	** read yuv2rgb.lut into virtual memory for random access by convert3()
-	** changed MAP_SHARED to MAP_RIVATE | MAP_POPULATE for 0.1s per frame performance improvemnt
-	*/	
-	uint16_t *lut_ptr = mmap(NULL, lut_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, lut_fd, 0);
-	if(lut_ptr == MAP_FAILED){
-		printf("lut - mmap failed errno=%d\n", errno);
-		return(0);
-	}/*eo if*/
+	** set up rgb565file buffer
+	*/
+	orig_rgb565ptr = rgb565ptr = 
+		(uint8_t*)malloc(cap_geo.width*cap_geo.height*2);
+	memset(rgb565ptr, 0, cap_geo.width*cap_geo.height*2);
 
 	/*
-	** use madvise() for mmap() performance improvement
+	** yuv422 to rgb565 conversion tables
 	*/
-	madvise(lut_ptr, lut_size, MADV_WILLNEED);
+	if(fused){
+		if(init_simd() < 0)
+			exit(1);
+	}else{
+		if(convert == 3 && lut_load("/home/root/yuv2rgb.lut") < 0)
+			exit(1);
+		if(convert == 5 && init_simd() < 0)
+			exit(1);
+		if(convert == 5 && strcmp(simd_isa, "scalar") == 0 && 
+		   getenv("SV5_ISA") == NULL)
+			fprintf(stderr, "convert5 - no simd kernels in this build"
+				" or cpu, running scalar (arm needs -mfpu=neon)\n");
+	}/*eo if*/
 
 	/*
-	** read yuv2rgb look up table into memory
+	** haar dwt worker pool
 	*/
-	uint8_t *lut_buf;
-	for(i=0; i<lut_size/4096; i++){
-		lseek(lut_fd, (long)(i*4096), SEEK_SET);
-		read(lut_fd, lut_buf, 1);
-	}/*eo for*/
-	
+	if(threads){
+		if(init_simd() < 0 || pool_init(threads) < 0)
+			exit(1);
+	}/*eo if*/
 
 	/*
 	** clear console and turn off cursor
@@ -367,73 +795,89 @@ int main(void)
 	/*
 	** allocate output buffer for haar dwt result
 	*/	
-	uint16_t *imgout_ptr = malloc(sizeof(uint8_t)*432*240*2);
-	memset(imgout_ptr, 0xff, 432*240*2);
+	uint16_t *imgout_ptr = malloc(cap_geo.width*cap_geo.height*2);
+	memset(imgout_ptr, 0xff, cap_geo.width*cap_geo.height*2);
+
+	/*
+	** denoise planes and the keys that adjust the threshold
+	*/
+	if(denoise){
+		denoise_planes = malloc(3*cap_geo.width*cap_geo.height*
+					sizeof(int16_t));
+		if(denoise_planes == NULL){
+			printf("denoise - malloc failed\n");
+			exit(1);
+		}/*eo if*/
+		if(init_simd() < 0)
+			exit(1);
+	}/*eo if*/
+	if(denoise || views)
+		keys_open();
 
 	/*
 	** end of initialization
 	*/	
-	if(tlog) clock_gettime(CLOCK_REALTIME, &init_time_end);
+	if(tlog) clock_gettime(CLOCK_MONOTONIC, &init_time_end);
 
 	/*******************************************************
 	********************************************************
 	** begin streaming loop
 	********************************************************
 	*******************************************************/
-	if(tlog) clock_gettime(CLOCK_REALTIME, &fps_start_time);
-	while(count){
+	/*
+	** hardware counters cover the serial loop, they count the calling
+	** thread only
+	*/
+	if(tlog && !pipeline && perf_open() == 0)
+		perf_start();
+
+	if(tlog) clock_gettime(CLOCK_MONOTONIC, &fps_start_time);
+	if(pipeline){
 
 		/*
-		** provide camera with a buffer to fill
+		** one thread per stage, throughput is bounded by the
+		** slowest stage
 		*/
-		v4l2_buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-		v4l2_buf.memory = V4L2_MEMORY_MMAP;
-		result = ioctl(vid_fd, VIDIOC_QBUF, &v4l2_buf);
-		if( result < 0)
-		{
-			perror("VIDIOC_QBUF");
+		if(run_pipeline(tlog ? count : 0) < 0)
 			exit(1);
-		}/*eo if*/
 
-		/* 
-		** the buffer has been filled by the video camera
-		** get the buffer for futher processing 
-		*/	
-		result = ioctl(vid_fd, VIDIOC_DQBUF, &v4l2_buf);
-		if( result < 0)
-		{
-			perror("VIDIOC_DQBUF");
-			printf("ERRNO %d\n", errno);
-			exit(1);
-		}/*eo if*/
+	}else{
 
-		/*
-		** convert yuyv422 to rgb565 using look up table
-		*/
-		convert3(cbp, rgb565ptr, lut_ptr);	
+		struct frame frame;
+		frame.rgb565 = rgb565ptr;
+		frame.dwt = imgout_ptr;
 
-		/*
-		** display basic video stream
-		*/
-		//display_LCD4(fbp, rgb565ptr);
-		
+		while(count){
 
-		/*
-		** process image using haar dwt
-		*/
-		HaarDwt((uint16_t*)rgb565ptr, imgout_ptr);
+			/*
+			** get the next filled buffer from the camera
+			*/
+			if(capture_next(&v4l2_buf) < 0)
+				exit(1);
+			frame.index = v4l2_buf.index;
+			frame.yuyv = cbp = cap_buf[v4l2_buf.index];
+			frame_capture_stamps(&frame, &v4l2_buf);
 
-		/*
-		** display haar dwt video stream
-		*/
-		display_LCD4(fbp,(uint8_t*)imgout_ptr);
+			/*
+			** convert and process the frame, then display it
+			*/
+			process_frame(&frame);
+			display_frame(&frame);
+
+			/*
+			** give the buffer back to the camera
+			*/
+			if(capture_release(v4l2_buf.index) < 0)
+				exit(1);
 				
-		/*
-		** timing
-		*/
-		if(tlog) count--;
+			/*
+			** timing
+			*/
+			if(tlog) count--;
 
-	}/*eo while*/
+		}/*eo while*/
+
+	}/*eo if*/
 
 	/*******************************************************
 	********************************************************
@@ -445,13 +889,14 @@ int main(void)
 	** benchmark timing
 	*/	
 	if(tlog){
-		clock_gettime(CLOCK_REALTIME, &fps_end_time);
+		clock_gettime(CLOCK_MONOTONIC, &fps_end_time);
+		perf_stop(perf_val);
+		perf_close();
 		/*
-		** initialization time
+		** initialization time, measured once
 		*/
 		t_diff = (init_time_end.tv_sec - init_time_start.tv_sec) + 
 	        (double)(init_time_end.tv_nsec - init_time_start.tv_nsec)/1000000000.0d;
-		t_diff = t_diff/SAMPLE_SIZE;
 		printf("initialization time: %f sec\n", t_diff);
 
 		/*
@@ -459,34 +904,105 @@ int main(void)
 		*/
 		t_diff = (fps_end_time.tv_sec - fps_start_time.tv_sec) + 
 	        (double)(fps_end_time.tv_nsec - fps_start_time.tv_nsec)/1000000000.0d;
-		t_diff = t_diff/SAMPLE_SIZE;
+		t_diff = t_diff/nframes;
 		fps = (double)1/t_diff;
-		printf("%f sec/frame %f frames/sec\n", t_diff, fps);
+		printf("%f sec/frame %f frames/sec %ld processed %ld dropped\n", 
+			t_diff, fps, frames_processed, frames_dropped);
+		printf("capture %dx%d stride %d, framebuffer %dx%d stride %d\n",
+			cap_geo.width, cap_geo.height, cap_geo.stride,
+			fb_geo.width, fb_geo.height, fb_geo.stride);
+		if(convert == 5 || fused || threads || denoise)
+			printf("simd: %s\n", simd_isa);
+		if(threads)
+			printf("haar dwt threads: %d\n", threads);
+		printf("framebuffer blit: %s\n", blit_mode);
+		if(scale || views){
+			struct view *v = comp.v;
+
+			printf("views: %s", view_layouts[comp.layout]);
+			for(v=comp.v; v<comp.v + comp.nviews; v++)
+				printf(", %s%s%s %s", v->src == VIEW_SRC_RAW ? 
+				       "raw" : "dwt", v->band < 0 ? "" : " ", 
+				       v->band < 0 ? "" : view_bands[v->band],
+				       !v->scaled ? "1:1" : v->s.mode == 
+				       SCALE_NEAREST ? "nearest" : "bilinear");
+			printf("\n");
+		}/*eo if*/
+		if(dbuf)
+			printf("framebuffer: double buffered, FBIOPAN_DISPLAY"
+			       "%s\n", vsync ? " + FBIO_WAITFORVSYNC" : "");
+		if(denoise)
+			printf("denoise: threshold %d %s, %d levels\n", 
+			       denoise_thresh, denoise_soft ? "soft" : "hard",
+			       DENOISE_LEVELS);
+		if(lut_ptr)
+			lut_report(stdout);
+		for(i=0; i<NPERF; i++){
+			if(perf_val[i] < 0) continue;
+			printf("%s %.0f/frame  ", perf_name[i], 
+			       (double)perf_val[i]/nframes);
+			nperf++;
+		}/*eo for*/
+		if(nperf) printf("\n");
+
+		/*
+		** capture buffers in flight when a frame was captured, with
+		** -p also for the frames still in the pipeline at the end
+		*/
+		printf("%d capture buffers, in flight min %d avg %.2f max %d\n",
+			nbufs, inflight_min, inflight_samples ? 
+			(double)inflight_sum/inflight_samples : 0.0, inflight_max);
+		for(i=0; i<=nbufs; i++){
+			if(inflight_hist[i])
+				printf("  %2d in flight: %ld frames\n", i, 
+				       inflight_hist[i]);
+		}/*eo for*/
+
+		/*
+		** pipeline stage utilization and queue occupancy
+		*/
+		if(pipeline){
+			t_diff = t_diff*nframes;
+			printf("capture busy %5.1f%%  capture->process queue "
+			       "avg %.2f max %u\n", 100.0*stage_busy[0]/t_diff,
+			       cap_q.occ_samples ? 
+			       (double)cap_q.occ_sum/cap_q.occ_samples : 0.0,
+			       cap_q.occ_max);
+			printf("process busy %5.1f%%  process->display queue "
+			       "avg %.2f max %u\n", 100.0*stage_busy[1]/t_diff,
+			       proc_q.occ_samples ? 
+			       (double)proc_q.occ_sum/proc_q.occ_samples : 0.0,
+			       proc_q.occ_max);
+			printf("display busy %5.1f%%  display->capture queue "
+			       "avg %.2f max %u\n", 100.0*stage_busy[2]/t_diff,
+			       free_q.occ_samples ? 
+			       (double)free_q.occ_sum/free_q.occ_samples : 0.0,
+			       free_q.occ_max);
+		}/*eo if*/
+
+		/*
+		** per stage and end-to-end latency
+		*/
+		latency_report();
 	}/*eo if*/
 
 
 	/*
-	** deactivate streaming 
+	** deactivate streaming and close the capture source
 	*/
-	if (ioctl(vid_fd, VIDIOC_STREAMOFF, &type) < 0)
-	{
-		perror("VIDIOC_STREAMOFF");
-		exit(1);
-	}//eo if
+	source->close();
 
 	/*
 	** clean up
 	*/
 
 	/*
-	** close webcam
-	*/
-	close(vid_fd);
-	munmap(cbp, v4l2_buf.length);
-
-	/*
-	** close framebuffer
+	** close framebuffer, the console is on the first page
 	*/
+	if(dbuf && !fb_file){
+		vinfo.yoffset = 0;
+		ioctl(fb_fd, FBIOPAN_DISPLAY, &vinfo);
+	}/*eo if*/
 	close(fb_fd);
 	munmap(fbp, screensize);
 	
@@ -499,74 +1015,228 @@ int main(void)
 	/*
 	** lut 
 	*/
-	close(lut_fd);
-	munmap(lut_ptr,(lut_size));
+	if(lut_hdr){
+		close(lut_fd);
+		munmap(lut_hdr, LUT_OFFSET + lut_size);
+	}/*eo if*/
+	if(lut_map)
+		munmap(lut_map, lut_map_size);
 
-	printf("done\n");
-	return 0;
+	/*
+	** haar dwt worker pool
+	*/
+	if(threads)
+		pool_shutdown();
+
+	/*
+	** denoise planes and stdin
+	*/
+	if(denoise){
+		keys_close();
+		free(denoise_planes);
+	}/*eo if*/
+	if(scale || views)
+		compose_free(&comp);
+
+	printf("done\n");
+	return 0;
 
 }/*eo main*****************************/
+#endif /*SV5_NO_MAIN*/
 
 /*
-** display_HDMI
+** row blit engine
+** every display routine places its image with blit_clip(): centred in
+** the visible framebuffer area (or the hidden page when double 
+** buffered) and clipped to it, a larger image shows its centre. whole
+** rows are then copied with blit_row, memcpy or, on x86, non-temporal
+** 16 byte stores that go around the cache into the write-combining
+** framebuffer memory. blit_flush() orders the streaming stores before
+** the frame is shown.
 */
-int display_HDMI(void *fbp, uint8_t *rgb565ptr){
+char *blit_mode = "memcpy";
+static int blit_stream = 0;
 
-	int x=0,y=0,idx=0;
-	uint8_t pxlsb=0,pxmsb=0;
-	uint8_t *orig_rgb565ptr = rgb565ptr;	/*debug*/
-	
-	idx = idx+(WUXGA_WIDTH*(HVGA_WIDTH-WQVGA_WIDTH));		
-		
-	for(y=0; y<WQVGA_HEIGHT; y++){
-		for(x=0; x<WQVGA_WIDTH; x++){
-			*(uint8_t*)(fbp+idx+(HVGA_HEIGHT-WQVGA_HEIGHT))
-				    = *rgb565ptr; 	
-			idx++;
-			rgb565ptr++;
-			*(uint8_t*)(fbp+idx+32) = *rgb565ptr; 
-			idx++;
-			rgb565ptr++;
+static void blit_row_memcpy(uint16_t *dst, const uint16_t *src, int npixels){
 
-		}/*eo for*/
-		idx = idx+((WUXGA_WIDTH -WQVGA_WIDTH)*2);
+	memcpy(dst, src, npixels*2);
+
+}/*eo blit_row_memcpy*/
+
+void (*blit_row)(uint16_t *dst, const uint16_t *src, int npixels) = 
+	blit_row_memcpy;
+
+#if defined(__x86_64__) || defined(__i386__)
+static void blit_row_stream(uint16_t *dst, const uint16_t *src, int npixels){
+
+	/*
+	** pixels up to the first 16 byte aligned destination
+	*/
+	while(((uintptr_t)dst & 15) && npixels){
+		*dst++ = *src++;
+		npixels--;
+	}/*eo while*/
+
+	for(; npixels >= 8; npixels -= 8){
+		_mm_stream_si128((__m128i *)dst, 
+				 _mm_loadu_si128((const __m128i *)src));
+		dst += 8;
+		src += 8;
 	}/*eo for*/
 
-	return(0);
+	while(npixels--)
+		*dst++ = *src++;
 
-}/*eo display_HDMI*/
+}/*eo blit_row_stream*/
+#endif
 
 /*
-** display the frame buffer on LCD4
+** blit_select
+** use the named row copy (memcpy, stream), -1 if this build or cpu does
+** not have it
 */
-int display_LCD4(void *fbp, void *filebuf){
+int blit_select(char *mode){
+
+	if(strcmp(mode, "memcpy") == 0){
+		blit_row = blit_row_memcpy;
+		blit_stream = 0;
+		blit_mode = "memcpy";
+		return(0);
+	}/*eo if*/
 
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(strcmp(mode, "stream") == 0 && __builtin_cpu_supports("sse2")){
+		blit_row = blit_row_stream;
+		blit_stream = 1;
+		blit_mode = "stream";
+		return(0);
+	}/*eo if*/
+#endif
 
-	int i=0,j=0,idx=0;
-	uint16_t *fbptr = fbp;
-	uint16_t *filebuf_ptr = filebuf;
-	uint16_t pixel=0;
-		
-	idx = HVGA_WIDTH*((HVGA_HEIGHT-WQVGA_HEIGHT)/2);
+	return(-1);
 
-	for(i=0; i<WQVGA_HEIGHT; i++){		/*row*/
+}/*eo blit_select*/
 
-		idx=idx+((HVGA_WIDTH-WQVGA_WIDTH)/2);
+/*
+** init_blit
+** streaming stores into a framebuffer device where available, a fake
+** one in a regular file is ordinary cached memory and gets memcpy.
+** SV5_BLIT overrides.
+*/
+int init_blit(void){
 
-		for(j=0; j<WQVGA_WIDTH; j++){	/*col*/
+	char *mode = getenv("SV5_BLIT");
+
+	if(mode){
+		if(blit_select(mode) < 0){
+			fprintf(stderr, "SV5_BLIT=%s not supported\n", mode);
+			return(-1);
+		}/*eo if*/
+		return(0);
+	}/*eo if*/
 
-			*(fbptr+idx)=*filebuf_ptr;
-			idx++;
-			filebuf_ptr++;
+	if(!fb_file && blit_select("stream") == 0) return(0);
 
-		}/*eo for*/
+	return(blit_select("memcpy"));
 
-		idx=idx+((HVGA_WIDTH-WQVGA_WIDTH)/2);
-	
+}/*eo init_blit*/
+
+void blit_flush(void){
+
+#if defined(__x86_64__) || defined(__i386__)
+	if(blit_stream)
+		_mm_sfence();
+#endif
+
+}/*eo blit_flush*/
+
+/*
+** blit_clip
+** visible part of a width x height image centred in region r of the 
+** visible framebuffer area (all of it if r is NULL): its first source
+** column and row, its size and the framebuffer address it starts at
+** (vinfo.xoffset/yoffset, xres/yres, finfo.line_length). returns -1 if
+** there is no framebuffer, image or region.
+*/
+int blit_clip(void *fbp, const struct region *r, int width, int height, 
+	      struct blit_area *a){
+
+	struct region all = { 0, 0, vinfo.xres, vinfo.yres };
+	long x=0, y=0;
+
+	if(r == NULL)
+		r = &all;
+	if(fbp == NULL || width < 1 || height < 1 || r->x < 0 || r->y < 0 ||
+	   r->width < 1 || r->height < 1 || 
+	   r->x + r->width > (int)vinfo.xres || 
+	   r->y + r->height > (int)vinfo.yres)
+		return(-1);
+
+	a->width = width < r->width ? width : r->width;
+	a->height = height < r->height ? height : r->height;
+	a->sx = (width - a->width)/2;
+	a->sy = (height - a->height)/2;
+	a->y = r->y + (r->height - a->height)/2;
+	x = vinfo.xoffset + r->x + (r->width - a->width)/2;
+	y = (dbuf ? fb_back : vinfo.yoffset) + a->y;
+	a->dst = (uint16_t *)((uint8_t *)fbp + y*finfo.line_length + x*2);
+
+	return(0);
+
+}/*eo blit_clip*/
+
+/*
+** blit_rgb565
+** copy a width x height rgb565 image with a line length of src_stride
+** bytes into region r of the framebuffer (NULL for all of it), a 
+** src_stride of 0 repeats the first row
+*/
+int blit_rgb565(void *fbp, const struct region *r, const void *src, 
+		int width, int height, int src_stride){
+
+	struct blit_area a;
+	const uint8_t *s=NULL;
+	uint16_t *d=NULL;
+	int y=0;
+
+	if(blit_clip(fbp, r, width, height, &a) < 0)
+		return(-1);
+
+	s = (const uint8_t *)src + (long)a.sy*src_stride + a.sx*2;
+	d = a.dst;
+	for(y=0; y<a.height; y++){
+		blit_row(d, (const uint16_t *)s, a.width);
+		d += finfo.line_length/2;
+		s += src_stride;
 	}/*eo for*/
+	blit_flush();
+	osd_damage(a.y, a.height);
 
 	return(0);
 
+}/*eo blit_rgb565*/
+
+/*
+** display_HDMI
+** copy of a cap_geo rgb565 frame, centred in the framebuffer
+*/
+int display_HDMI(void *fbp, uint8_t *rgb565ptr){
+
+	return(blit_rgb565(fbp, NULL, rgb565ptr, cap_geo.width, cap_geo.height, 
+			   cap_geo.width*2));
+
+}/*eo display_HDMI*/
+
+/*
+** display the frame buffer on LCD4
+** the cap_geo frame is centred in the visible framebuffer area
+*/
+int display_LCD4(void *fbp, void *filebuf){
+
+	return(blit_rgb565(fbp, NULL, filebuf, cap_geo.width, cap_geo.height, 
+			   cap_geo.width*2));
+
 }/*eo Display_LCD4*/
 
 /*
@@ -575,7 +1245,9 @@ int display_LCD4(void *fbp, void *filebuf){
 */
 int convert2(void *cbp, uint8_t *rgb565ptr){
 
-	int i=0;
+	int i=0, row=0;
+	const int height = cap_geo.height, stride = cap_geo.stride;
+	const int line = cap_geo.width*2;
 	uint8_t *yuvptr = NULL;
 	uint8_t *orig_yuvptr = NULL;
 	uint8_t Y0,Y1,U0,V0;
@@ -584,45 +1256,52 @@ int convert2(void *cbp, uint8_t *rgb565ptr){
 	
 	orig_yuvptr = yuvptr = (uint8_t *)cbp;
 
-	for(i=0; i<YUYV_SIZE; i++){
-		Y1 = *yuvptr;	/*Y1*/
-		i++;
-		yuvptr++;
-		V0 = *yuvptr;	/*V0*/
-		i++;
-		yuvptr++;
-		Y0 = *yuvptr;	/*Y0*/
-		i++;
-		yuvptr++;
-		U0 = *yuvptr;	/*U0*/
-		yuvptr++;	/*next 4 byte macropixel*/
+	for(row=0; row<height; row++){
 
 		/*
-		** convert yuv422 to rgb565
+		** capture lines may be padded to cap_geo.stride bytes
 		*/
-		rgb565 = yuv422_to_rgb565(Y0,U0,V0);
+		yuvptr = (uint8_t *)cbp + row*stride;
+		for(i=0; i<line; i++){
+			Y1 = *yuvptr;	/*Y1*/
+			i++;
+			yuvptr++;
+			V0 = *yuvptr;	/*V0*/
+			i++;
+			yuvptr++;
+			Y0 = *yuvptr;	/*Y0*/
+			i++;
+			yuvptr++;
+			U0 = *yuvptr;	/*U0*/
+			yuvptr++;	/*next 4 byte macropixel*/
+
+			/*
+			** convert yuv422 to rgb565
+			*/
+			rgb565 = yuv422_to_rgb565(Y0,U0,V0);
 				
-		pixel = rgb565;			
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565;			
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 
-		pixel = rgb565 >> 8;		
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565 >> 8;		
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 
-		/*
-		** convert yuv422 to rgb565
-		*/
-		rgb565 = yuv422_to_rgb565(Y1,U0,V0);
+			/*
+			** convert yuv422 to rgb565
+			*/
+			rgb565 = yuv422_to_rgb565(Y1,U0,V0);
 				
-		pixel = rgb565;			
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565;			
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 
-		pixel = rgb565 >> 8;		
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565 >> 8;		
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 
+		}/*eo for*/
 	}/*eo for*/
 	
 	return(0);
@@ -635,7 +1314,9 @@ int convert2(void *cbp, uint8_t *rgb565ptr){
 */
 int convert3(void *cbp, uint8_t *rgb565ptr, uint16_t *pbuf){
 
-	int i=0;
+	int i=0, row=0;
+	const int height = cap_geo.height, stride = cap_geo.stride;
+	const int line = cap_geo.width*2;
 	uint8_t *yuvptr = NULL;
 	uint8_t Y0,Y1,U0,V0;
 	uint8_t pixel;
@@ -643,52 +1324,420 @@ int convert3(void *cbp, uint8_t *rgb565ptr, uint16_t *pbuf){
 		
 	yuvptr = (uint8_t *)cbp;
 
-	for(i=0; i<YUYV_SIZE; i++){
-		Y1 = *yuvptr;	/*Y1*/
-		i++;
-		yuvptr++;
-		V0 = *yuvptr;	/*V0*/
-		i++;
-		yuvptr++;
-		Y0 = *yuvptr;	/*Y0*/
-		i++;
-		yuvptr++;
-		U0 = *yuvptr;	/*U0*/
-		yuvptr++;	/*next 4 byte macropixel*/
+	for(row=0; row<height; row++){
 
 		/*
-		** convert yuv422 to rgb565
+		** capture lines may be padded to cap_geo.stride bytes
 		*/
-		rgb565 = *(pbuf + ((Y0*256*256)+(U0*256)+V0));
+		yuvptr = (uint8_t *)cbp + row*stride;
+		for(i=0; i<line; i++){
+			Y1 = *yuvptr;	/*Y1*/
+			i++;
+			yuvptr++;
+			V0 = *yuvptr;	/*V0*/
+			i++;
+			yuvptr++;
+			Y0 = *yuvptr;	/*Y0*/
+			i++;
+			yuvptr++;
+			U0 = *yuvptr;	/*U0*/
+			yuvptr++;	/*next 4 byte macropixel*/
+
+			/*
+			** convert yuv422 to rgb565
+			*/
+			rgb565 = *(pbuf + ((Y0*256*256)+(U0*256)+V0));
 				
-		pixel = rgb565;			
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565;			
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 
-		pixel = rgb565 >> 8;		
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565 >> 8;		
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 		
 
-		/*
-		** convert yuv422 to rgb565
-		*/
-		rgb565 = *(pbuf + ((Y1*256*256)+(U0*256)+V0));
+			/*
+			** convert yuv422 to rgb565
+			*/
+			rgb565 = *(pbuf + ((Y1*256*256)+(U0*256)+V0));
 		
-		pixel = rgb565;			
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565;			
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 
-		pixel = rgb565 >> 8;		
-		*rgb565ptr = pixel;
-		rgb565ptr++;
+			pixel = rgb565 >> 8;		
+			*rgb565ptr = pixel;
+			rgb565ptr++;
 
+		}/*eo for*/
 	}/*eo for*/
 	
 	return(0);
 
 }/*eo convert3*/
 
+/*
+** compact yuv422 to rgb565 tables used by convert4()
+**
+** the ITU-R 601 coefficients are exact multiples of 1/1000, so the
+** floating point result of yuv422_to_rgb565() is the exact value
+** truncated, and an exact integer value is never rounded down. each
+** contribution is rounded to 16.16 fixed point (error < 2^-17) and the
+** Y table carries a small bias (8/65536) so that exact integers are not
+** truncated to the integer below. any value that is not an exact integer
+** is at least 1/1000 away from one, far more than bias plus error, so the
+** result is bit-identical to yuv422_to_rgb565() for all 2^24 inputs.
+**
+** 5 x 256 int32 contributions + 832 byte clamp table = 5.9 KB, computed
+** by the compiler from the same expressions (TAB_Y .. TAB_CLAMP above, 
+** rounded half away from zero as lround() does) so nothing is built or
+** faulted in at start-up
+*/
+
+/*
+** convert4_pixels
+** uses the compact tables to convert npixels (even) yuv422 pixels to
+** rgb565. produces the same bgr565 pixels as convert2() and convert3()
+*/
+void convert4_pixels(uint8_t *yuvptr, uint16_t *outptr, int npixels){
+
+	int i=0;
+	const uint8_t *clamp = tab_clamp - TAB_CLAMP_MIN;
+	int32_t y=0, rv=0, guv=0, bu=0;
+	uint8_t Y0,Y1,U0,V0;
+	uint8_t red, green, blue;
+
+	for(i=0; i<npixels; i+=2){
+		Y1 = yuvptr[0];	/*Y1*/
+		V0 = yuvptr[1];	/*V0*/
+		Y0 = yuvptr[2];	/*Y0*/
+		U0 = yuvptr[3];	/*U0*/
+		yuvptr += 4;	/*next 4 byte macropixel*/
+
+		/*
+		** chroma contributions are shared by both pixels
+		*/
+		rv = tab_rv[V0];
+		guv = tab_gu[U0] + tab_gv[V0];
+		bu = tab_bu[U0];
+
+		y = tab_y[Y0];
+		red = clamp[(y + rv) >> 16];
+		green = clamp[(y + guv) >> 16];
+		blue = clamp[(y + bu) >> 16];
+		*outptr++ = ((blue >> 3) << 11) | ((green >> 2) << 5) | (red >> 3);
+
+		y = tab_y[Y1];
+		red = clamp[(y + rv) >> 16];
+		green = clamp[(y + guv) >> 16];
+		blue = clamp[(y + bu) >> 16];
+		*outptr++ = ((blue >> 3) << 11) | ((green >> 2) << 5) | (red >> 3);
+
+	}/*eo for*/
+
+}/*eo convert4_pixels*/
+
+/*
+** convert_frame
+** run a row kernel over a cap_geo frame, in one call when the capture
+** lines are not padded
+*/
+static void convert_frame(void (*pixels)(uint8_t *, uint16_t *, int), 
+			  uint8_t *yuvptr, uint16_t *outptr){
+
+	int row=0;
+
+	if(cap_geo.stride == cap_geo.width*2){
+		pixels(yuvptr, outptr, cap_geo.width*cap_geo.height);
+		return;
+	}/*eo if*/
+
+	for(row=0; row<cap_geo.height; row++){
+		pixels(yuvptr, outptr, cap_geo.width);
+		yuvptr += cap_geo.stride;
+		outptr += cap_geo.width;
+	}/*eo for*/
+
+}/*eo convert_frame*/
+
+/*
+** convert4
+** uses the compact tables to convert a yuv422 frame to rgb565
+*/
+int convert4(void *cbp, uint8_t *rgb565ptr){
+
+	convert_frame(convert4_pixels, cbp, (uint16_t *)rgb565ptr);
+
+	return(0);
+
+}/*eo convert4*/
+
+/*
+** convert5
+** simd fixed point yuv422 to rgb565 conversion
+**
+** the 601 coefficients times 2000 are integers, so each channel is first
+** computed as the exact integer 2000*value+1 (16 bit multiplies with 32
+** bit sums), then scaled by 1/2000 in single precision and truncated.
+** the +1 keeps the scaled value 0.0005 above the exact one and at least
+** 0.0005 below the next integer, while the float error is below 0.0001,
+** so the truncated result is exactly the one yuv422_to_rgb565() computes.
+** saturating packs clamp to 0..255.
+**
+** the widest kernel the cpu supports is picked by init_simd(),
+** remaining pixels and cpus without simd use convert4_pixels().
+*/
+char *simd_isa = "scalar";
+void (*convert5_pixels)(uint8_t *yuvptr, uint16_t *outptr, int npixels) = 
+	convert4_pixels;
+
+#define C5_Y	(2*1164)
+#define C5_RV	(2*1596)
+#define C5_GV	(-2*813)
+#define C5_GU	(-2*391)
+#define C5_BU	(2*2018)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/*
+** four pixels from two macropixels
+** each 32 bit lane of w holds two 16 bit values: (V<<16)|Y1, (U<<16)|Y0,
+** (V<<16)|Y1, (U<<16)|Y0. _mm_madd_epi16 against (k,0) multiplies the
+** low half of every lane by k.
+*/
+static inline void c5_quad_sse2(__m128i w, __m128i *r, __m128i *g, __m128i *b){
+
+	const __m128i mask = _mm_set1_epi32(0xffff);
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128 scale = _mm_set1_ps(1.0f/2000.0f);
+	__m128i Y, U, V, ty;
+
+	/*
+	** pixel order Y0,Y1 of each macropixel, chroma duplicated
+	*/
+	Y = _mm_and_si128(_mm_shuffle_epi32(w, _MM_SHUFFLE(2,3,0,1)), mask);
+	V = _mm_srli_epi32(_mm_shuffle_epi32(w, _MM_SHUFFLE(2,2,0,0)), 16);
+	U = _mm_srli_epi32(_mm_shuffle_epi32(w, _MM_SHUFFLE(3,3,1,1)), 16);
+	Y = _mm_sub_epi32(Y, _mm_set1_epi32(16));
+	V = _mm_sub_epi32(V, _mm_set1_epi32(128));
+	U = _mm_sub_epi32(U, _mm_set1_epi32(128));
+
+	ty = _mm_add_epi32(_mm_madd_epi16(Y, _mm_set1_epi32(C5_Y & 0xffff)), one);
+	*r = _mm_add_epi32(ty, _mm_madd_epi16(V, _mm_set1_epi32(C5_RV & 0xffff)));
+	*g = _mm_add_epi32(ty, 
+	     _mm_add_epi32(_mm_madd_epi16(V, _mm_set1_epi32(C5_GV & 0xffff)),
+			   _mm_madd_epi16(U, _mm_set1_epi32(C5_GU & 0xffff))));
+	*b = _mm_add_epi32(ty, _mm_madd_epi16(U, _mm_set1_epi32(C5_BU & 0xffff)));
+
+	*r = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(*r), scale));
+	*g = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(*g), scale));
+	*b = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(*b), scale));
+
+}/*eo c5_quad_sse2*/
+
+/*
+** eight pixels per iteration
+*/
+static void convert5_pixels_sse2(uint8_t *yuvptr, uint16_t *outptr, int npixels){
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i max = _mm_set1_epi16(255);
+	__m128i m, rl, gl, bl, rh, gh, bh, r, g, b, px;
+	int i=0;
+
+	for(i=0; i+8<=npixels; i+=8){
+		m = _mm_loadu_si128((__m128i *)yuvptr);
+		c5_quad_sse2(_mm_unpacklo_epi8(m, zero), &rl, &gl, &bl);
+		c5_quad_sse2(_mm_unpackhi_epi8(m, zero), &rh, &gh, &bh);
+
+		/*
+		** clamp to 0..255
+		*/
+		r = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(rl, rh), zero), max);
+		g = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(gl, gh), zero), max);
+		b = _mm_min_epi16(_mm_max_epi16(_mm_packs_epi32(bl, bh), zero), max);
+
+		/*
+		** bgr565
+		*/
+		px = _mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(b, 3), 11),
+		     _mm_or_si128(_mm_slli_epi16(_mm_srli_epi16(g, 2), 5),
+				  _mm_srli_epi16(r, 3)));
+		_mm_storeu_si128((__m128i *)outptr, px);
+
+		yuvptr += 16;
+		outptr += 8;
+	}/*eo for*/
+
+	if(i < npixels)
+		convert4_pixels(yuvptr, outptr, npixels-i);
+
+}/*eo convert5_pixels_sse2*/
+
+/*
+** avx2 version of c5_quad_sse2, each 128 bit lane holds two macropixels
+*/
+__attribute__((target("avx2")))
+static inline void c5_quad_avx2(__m256i w, __m256i *r, __m256i *g, __m256i *b){
+
+	const __m256i mask = _mm256_set1_epi32(0xffff);
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256 scale = _mm256_set1_ps(1.0f/2000.0f);
+	__m256i Y, U, V, ty;
+
+	Y = _mm256_and_si256(_mm256_shuffle_epi32(w, _MM_SHUFFLE(2,3,0,1)), mask);
+	V = _mm256_srli_epi32(_mm256_shuffle_epi32(w, _MM_SHUFFLE(2,2,0,0)), 16);
+	U = _mm256_srli_epi32(_mm256_shuffle_epi32(w, _MM_SHUFFLE(3,3,1,1)), 16);
+	Y = _mm256_sub_epi32(Y, _mm256_set1_epi32(16));
+	V = _mm256_sub_epi32(V, _mm256_set1_epi32(128));
+	U = _mm256_sub_epi32(U, _mm256_set1_epi32(128));
+
+	ty = _mm256_add_epi32(
+	     _mm256_madd_epi16(Y, _mm256_set1_epi32(C5_Y & 0xffff)), one);
+	*r = _mm256_add_epi32(ty, 
+	     _mm256_madd_epi16(V, _mm256_set1_epi32(C5_RV & 0xffff)));
+	*g = _mm256_add_epi32(ty, _mm256_add_epi32(
+	     _mm256_madd_epi16(V, _mm256_set1_epi32(C5_GV & 0xffff)),
+	     _mm256_madd_epi16(U, _mm256_set1_epi32(C5_GU & 0xffff))));
+	*b = _mm256_add_epi32(ty, 
+	     _mm256_madd_epi16(U, _mm256_set1_epi32(C5_BU & 0xffff)));
+
+	*r = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(*r), scale));
+	*g = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(*g), scale));
+	*b = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(*b), scale));
+
+}/*eo c5_quad_avx2*/
+
+/*
+** sixteen pixels per iteration. the unpacks and packs work within each
+** 128 bit lane, so pixels 0-7 end up in the low lane and 8-15 in the high
+*/
+__attribute__((target("avx2")))
+static void convert5_pixels_avx2(uint8_t *yuvptr, uint16_t *outptr, int npixels){
+
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i max = _mm256_set1_epi16(255);
+	__m256i m, rl, gl, bl, rh, gh, bh, r, g, b, px;
+	int i=0;
+
+	for(i=0; i+16<=npixels; i+=16){
+		m = _mm256_loadu_si256((__m256i *)yuvptr);
+		c5_quad_avx2(_mm256_unpacklo_epi8(m, zero), &rl, &gl, &bl);
+		c5_quad_avx2(_mm256_unpackhi_epi8(m, zero), &rh, &gh, &bh);
+
+		r = _mm256_min_epi16(_mm256_max_epi16(
+		    _mm256_packs_epi32(rl, rh), zero), max);
+		g = _mm256_min_epi16(_mm256_max_epi16(
+		    _mm256_packs_epi32(gl, gh), zero), max);
+		b = _mm256_min_epi16(_mm256_max_epi16(
+		    _mm256_packs_epi32(bl, bh), zero), max);
+
+		px = _mm256_or_si256(_mm256_slli_epi16(_mm256_srli_epi16(b, 3), 11),
+		     _mm256_or_si256(_mm256_slli_epi16(_mm256_srli_epi16(g, 2), 5),
+				     _mm256_srli_epi16(r, 3)));
+		_mm256_storeu_si256((__m256i *)outptr, px);
+
+		yuvptr += 32;
+		outptr += 16;
+	}/*eo for*/
+
+	if(i < npixels)
+		convert5_pixels_sse2(yuvptr, outptr, npixels-i);
+
+}/*eo convert5_pixels_avx2*/
+
+#endif /*x86*/
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+/*
+** one channel of four pixels: (n*1/2000) truncated, narrowed to 16 bit
+*/
+static inline int16x4_t c5_scale_neon(int32x4_t n){
+
+	return(vqmovn_s32(vcvtq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(n), 
+						     1.0f/2000.0f))));
+
+}/*eo c5_scale_neon*/
+
+/*
+** eight pixels sharing the chroma in u and v, all from Y0 or all from Y1
+*/
+static inline uint16x8_t c5_octet_neon(int16x8_t y, int16x8_t u, int16x8_t v){
+
+	int32x4_t tyl, tyh;
+	uint16x8_t r, g, b;
+
+	tyl = vaddq_s32(vmull_n_s16(vget_low_s16(y), C5_Y), vdupq_n_s32(1));
+	tyh = vaddq_s32(vmull_n_s16(vget_high_s16(y), C5_Y), vdupq_n_s32(1));
+
+	r = vmovl_u8(vqmovun_s16(vcombine_s16(
+	    c5_scale_neon(vmlal_n_s16(tyl, vget_low_s16(v), C5_RV)),
+	    c5_scale_neon(vmlal_n_s16(tyh, vget_high_s16(v), C5_RV)))));
+	g = vmovl_u8(vqmovun_s16(vcombine_s16(
+	    c5_scale_neon(vmlal_n_s16(vmlal_n_s16(tyl, vget_low_s16(v), C5_GV),
+				      vget_low_s16(u), C5_GU)),
+	    c5_scale_neon(vmlal_n_s16(vmlal_n_s16(tyh, vget_high_s16(v), C5_GV),
+				      vget_high_s16(u), C5_GU)))));
+	b = vmovl_u8(vqmovun_s16(vcombine_s16(
+	    c5_scale_neon(vmlal_n_s16(tyl, vget_low_s16(u), C5_BU)),
+	    c5_scale_neon(vmlal_n_s16(tyh, vget_high_s16(u), C5_BU)))));
+
+	return(vorrq_u16(vshlq_n_u16(vshrq_n_u16(b, 3), 11),
+	       vorrq_u16(vshlq_n_u16(vshrq_n_u16(g, 2), 5), vshrq_n_u16(r, 3))));
+
+}/*eo c5_octet_neon*/
+
+/*
+** sixteen pixels per iteration, vld4 splits the macropixels into
+** Y1, V0, Y0, U0 and vst2 interleaves the Y0 and Y1 pixels again
+*/
+static void convert5_pixels_neon(uint8_t *yuvptr, uint16_t *outptr, int npixels){
+
+	uint8x8x4_t m;
+	uint16x8x2_t px;
+	int16x8_t y0, y1, u, v;
+	int i=0;
+
+	for(i=0; i+16<=npixels; i+=16){
+		m = vld4_u8(yuvptr);
+		y1 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(m.val[0])), 
+			       vdupq_n_s16(16));
+		v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(m.val[1])), 
+			      vdupq_n_s16(128));
+		y0 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(m.val[2])), 
+			       vdupq_n_s16(16));
+		u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(m.val[3])), 
+			      vdupq_n_s16(128));
+
+		px.val[0] = c5_octet_neon(y0, u, v);
+		px.val[1] = c5_octet_neon(y1, u, v);
+		vst2q_u16(outptr, px);
+
+		yuvptr += 32;
+		outptr += 16;
+	}/*eo for*/
+
+	if(i < npixels)
+		convert4_pixels(yuvptr, outptr, npixels-i);
+
+}/*eo convert5_pixels_neon*/
+
+#endif /*neon*/
+
+/*
+** convert5
+** convert a yuv422 frame to rgb565 with the selected simd kernel
+*/
+int convert5(void *cbp, uint8_t *rgb565ptr){
+
+	convert_frame(convert5_pixels, cbp, (uint16_t *)rgb565ptr);
+
+	return(0);
+
+}/*eo convert5*/
+
 /*
 ** yuv422 to rgb888 conversion
 */
@@ -838,115 +1887,58 @@ uint16_t rgb888_to_rgb565(uint32_t rgb888){
 }/*eo rgb888_to_rgb565*/
 
 /*
-** display RGB Color Bars on BeagleBone HDMI
+** color bars, eight bars across the cap_geo frame
 */
-int RGBColorBars_HDMI(void *fbp){
-
-	int x=0,y=0,idx=0;
-  	uint8_t pxlsb=0,pxmsb=0;
-		
-	idx = idx+(WUXGA_WIDTH*(HVGA_WIDTH-WQVGA_WIDTH));		
-		
-	for(y=0; y<WQVGA_HEIGHT; y++){
-		for(x=0; x<WQVGA_WIDTH; x++){
-			if(x>= 0 && x<= 53){
-				pxmsb = 0xff;	/*white*/
-				pxlsb = 0xff;
-			}/*eo if*/
-			if(x>= 54 && x<= 107){
-				pxmsb = 0xff;	/*yellow*/
-				pxlsb = 0xe0;
-			}/*eo if*/
-			if(x>= 108 && x<= 161){
-				pxmsb = 0x07;	/*cyan*/
-				pxlsb = 0xff;
-			}/*eo if*/
-			if(x>= 162 && x<= 215){
-				pxmsb = 0x07;	/*green*/
-				pxlsb = 0xe0;
-			}/*eo if*/
-			if(x>= 216 && x<= 269){
-				pxmsb = 0xf8;	/*magenta*/
-				pxlsb = 0x1f;
-			}/*eo if*/
-			if(x>= 270 && x<= 323){				
-				pxmsb = 0xf8;	/*red*/
-				pxlsb = 0x00;
-			}/*eo if*/
-			if(x>= 324 && x<= 377){
-				pxmsb = 0x00;	/*blue*/
-				pxlsb = 0x1f;
-			}/*eo if*/
-			if(x>= 378 && x<= 431){
-				pxmsb = 0x00;	/*black*/
-				pxlsb = 0x00;
-			}/*eo if*/
-			*(uint8_t*)(fbp+idx+(HVGA_HEIGHT-WQVGA_HEIGHT))
-				    = pxlsb; /*pixel lsb*/	
-			idx++;
-			*(uint8_t*)(fbp+idx+32) = pxmsb; /*pixel msb*/
-			idx++;
-		}/*eo for*/
-		idx = idx+((WUXGA_WIDTH -WQVGA_WIDTH)*2);
-	}/*eo for*/
-
-	return(0);
-
-}/*eo RGBColorBars_HDMI*/
+static const uint16_t color_bars[8] = {
+	WHITE, YELLOW, CYAN, GREEN, MAGENTA, RED, BLUE, BLACK
+};
 
 /*
-** display color bars on the BeagleBone LCD4
-*/		
-int RGBColorBars_LCD4(void *fbp){
+** color_bars_blit
+** one row of the bars repeated over the cap_geo frame
+*/
+static int color_bars_blit(void *fbp){
 
+	uint16_t line[MAX_FRAME_WIDTH];
+	int x=0;
 
-	int i=0,j=0,idx=0;
-	uint16_t *fbptr = fbp;
-	uint16_t pixel=0;
-	
-	idx = HVGA_WIDTH*((HVGA_HEIGHT-WQVGA_HEIGHT)/2);
+	for(x=0; x<cap_geo.width; x++)
+		line[x] = color_bars[x*8/cap_geo.width];
 
-	for(i=0; i<WQVGA_HEIGHT; i++){		/*row*/
+	return(blit_rgb565(fbp, NULL, line, cap_geo.width, cap_geo.height, 0));
 
-		idx=idx+((HVGA_WIDTH-WQVGA_WIDTH)/2);
+}/*eo color_bars_blit*/
 
-		for(j=0; j<WQVGA_WIDTH; j++){	/*col*/
+/*
+** display RGB Color Bars on BeagleBone HDMI
+*/
+int RGBColorBars_HDMI(void *fbp){
 
-			if(j>=   0 && j<=  53) pixel = WHITE;
-			if(j>=  54 && j<= 107) pixel = YELLOW;
-			if(j>= 108 && j<= 161) pixel = CYAN;
-			if(j>= 162 && j<= 215) pixel = GREEN;
-			if(j>= 216 && j<= 269) pixel = MAGENTA;
-			if(j>= 270 && j<= 323) pixel = RED;
-			if(j>= 324 && j<= 377) pixel = BLUE;
-			if(j>= 378 && j<= 431) pixel = BLACK;
-			
-			*(fbptr+idx)=pixel;
-			idx++;
+	return(color_bars_blit(fbp));
 
-		}/*eo for*/
+}/*eo RGBColorBars_HDMI*/
 
-		idx=idx+((HVGA_WIDTH-WQVGA_WIDTH)/2);
-	
-	}/*eo for*/
+/*
+** display color bars on the BeagleBone LCD4
+*/		
+int RGBColorBars_LCD4(void *fbp){
 
-	return(0);
+	return(color_bars_blit(fbp));
 
 }/*eo RGBColorBars_LCD4*/	
 
 
 /*
 ** opens and display raw rgb565 files using HDMI
+** the file is a cap_geo.width x cap_geo.height frame, a short file is
+** padded with black
 */
 int RGBDisplayFile_HDMI(void *fbp, char *filepath){
 
-	int x=0,y=0,idx=0;
-  	uint8_t pxlsb=0,pxmsb=0;
-
 	FILE *fp=NULL;
-	int errnum=0, fsize=0;
+	int errnum=0, fsize=0, ret=0;
 	struct stat filestat;
-	uint8_t *fbuf=NULL, *orig_fbuf=NULL;
+	uint8_t *fbuf=NULL;
 
 	fp = fopen(filepath, "r");
 	if(fp == NULL){
@@ -956,39 +1948,29 @@ int RGBDisplayFile_HDMI(void *fbp, char *filepath){
 	}/*eo if*/
 	fstat(fileno(fp), &filestat);
 	fsize = filestat.st_size;
-	orig_fbuf = fbuf = (uint8_t*)malloc(fsize);
+	if(fsize < cap_geo.width*cap_geo.height*2)
+		fsize = cap_geo.width*cap_geo.height*2;
+	fbuf = (uint8_t*)malloc(fsize);
+	if(fbuf == NULL){
+		fclose(fp);
+		return(-1);
+	}/*eo if*/
 	memset(fbuf, 0, fsize);
 	fread(fbuf,sizeof(uint8_t),fsize,fp);
 	fclose(fp);
-	
-	idx = idx+(WUXGA_WIDTH*(HVGA_WIDTH-WQVGA_WIDTH));		
-		
-	for(y=0; y<WQVGA_HEIGHT; y++){
-		for(x=0; x<WQVGA_WIDTH; x++){
-			pxlsb = *fbuf;
-			fbuf++;
-			pxmsb = *fbuf;
-			fbuf++;
-			*(uint8_t*)(fbp+idx+(HVGA_HEIGHT-WQVGA_HEIGHT))
-				    = pxlsb; /*pixel lsb*/	
-			idx++;
-			*(uint8_t*)(fbp+idx+32) = pxmsb; /*pixel msb*/
-			idx++;
-		}/*eo for*/
-		idx = idx+((WUXGA_WIDTH -WQVGA_WIDTH)*2);
-	}/*eo for*/
+
+	ret = blit_rgb565(fbp, NULL, fbuf, cap_geo.width, cap_geo.height, 
+			  cap_geo.width*2);
 	free(fbuf);
-	return(0);
+
+	return(ret);
 
 }/*eo RGBDisplayFile_HDMI*/
 
 
 /*
 ** Read a file into a buffer for display
-** file needs to be: 
-** WQVGA_WIDTH	432 
-** WQVGA_HEIGHT	240
-** FILEBUF_SIZE	WQVGA_WIDTH*WQVGA_HEIGHT*2
+** file needs to be a cap_geo.width x cap_geo.height rgb565 frame
 */
 int ReadRGBFile(void *filebuf, char *fpath){
 
@@ -1022,18 +2004,42 @@ int init_fb_color(void *fbp, uint16_t color){
 	int i=0;
 
 	/*
-	** initialize frame buffer color
+	** initialize frame buffer color, every line of the mapping
 	*/
 	fbptr=fbp;
-	for(i=0; i<HVGA_WIDTH*HVGA_HEIGHT; i++){
+	for(i=0; i<screensize/2; i++){
 		*fbptr = color;
 		fbptr++;
 	}/*eo for*/
+	osd_invalidate();
 
 	return(0);
 
 }/*eo init_fb_color*/
 
+/*
+** clear_fb_page
+** the page being drawn, with -b the page on the screen is left as it is
+*/
+int clear_fb_page(void *fbp, uint16_t color){
+
+	uint16_t *fbptr=NULL;
+	int x=0, y=0;
+
+	if(!dbuf)
+		return(init_fb_color(fbp, color));
+	for(y=0; y<(int)vinfo.yres; y++){
+		fbptr = (uint16_t *)((uint8_t *)fbp + 
+			((long)fb_back + y)*finfo.line_length);
+		for(x=0; x<(int)finfo.line_length/2; x++)
+			fbptr[x] = color;
+	}/*eo for*/
+	osd_damage(0, vinfo.yres);
+
+	return(0);
+
+}/*eo clear_fb_page*/
+
 /*
 ** write rgb565 buffer to a file
 */
@@ -1045,7 +2051,7 @@ int WriteRGBFile(void *filebuf, char *fpath){
 	** write buffer to file
 	*/
 	fd = fopen(fpath, "w");
-	fwrite(filebuf,sizeof(uint8_t),RGB565_SIZE,fd);
+	fwrite(filebuf,sizeof(uint8_t),cap_geo.width*cap_geo.height*2,fd);
 	fclose(fd);
 	
 	return(0);
@@ -1057,18 +2063,23 @@ int WriteRGBFile(void *filebuf, char *fpath){
 ** Transform rgb565 image to haar dwt rgb565 image
 **
 ** input variables:
+** int width, height is the frame size
 ** uint16_t *imgin_ptr is the input buffer
 ** uint16_t *imgout_ptr is the output buffer
 */
-int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr)
+static inline __attribute__((always_inline))
+int haar_dwt(int width, int height, uint16_t *imgin_ptr, uint16_t *imgout_ptr)
 {
 
-	#define QUAD_ROW_ORIGIN	432/2*240 	
-	#define QUAD_COL_OFFSET 432/2		
-	#define QUAD_ROW_OFFSET 432		
-	#define H_NUM_ROWS	240
-	#define H_NUM_COLS	432
-	#define H_ROW_WIDTH	432
+	/*
+	** quadrant offsets and sliding window bounds
+	*/
+	const int quad_row_origin = width/2*height;
+	const int quad_col_offset = width/2;
+	const int quad_row_width = width;
+	const int h_num_rows = height;
+	const int h_num_cols = width;
+	const int h_row_width = width;
 
 	/*
 	** input buffer indicies
@@ -1121,8 +2132,8 @@ int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr)
 	** this haar dwt uses a sliding window r1c1,r1c2,r2c1,r2c2
 	** to traverse the entire rgb565 image.
 	**
-	** H_ROW_WIDTH*i points to the first row (r1)
-	** H_ROW_WIDTH*(i+1) points to the second row (r2)
+	** h_row_width*i points to the first row (r1)
+	** h_row_width*(i+1) points to the second row (r2)
 	** index j points to the first column (c1) in the row (r1,r2)
 	** index j+1 points to the second column (c2) in the row (r1,r2)
 	*/
@@ -1130,29 +2141,29 @@ int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr)
 	/*
 	** two rows at a time until all rows processed
 	*/	
-	for(i=0; i<H_NUM_ROWS; i++){	
+	for(i=0; i<h_num_rows; i++){	
 		
 		/*
 		** calculate the output buffer row offset (quad_row_offset)
 		** and initialize output buffer column index (k) before 
 		** processing the rows and columns
 		*/
-		quad_row_offset = QUAD_ROW_OFFSET*h;	
+		quad_row_offset = quad_row_width*h;	
 		k=0;	
 
 		/*
 		** two columns at a time until all columns processed
 		*/
-		for(j=0; j<H_NUM_COLS; j++){	
+		for(j=0; j<h_num_cols; j++){	
 
 			/*
 			** sliding window
 			** get rgb565 pixels r1c1,r1c2,r2c1,r2c2
 			*/
-			r1c1 = *(imgin_ptr+(((H_ROW_WIDTH*i)+j)));		//r1c1
-			r1c2 = *(imgin_ptr+(((H_ROW_WIDTH*i)+(j+1))));		//r1c2
-			r2c1 = *(imgin_ptr+(((H_ROW_WIDTH*(i+1))+j)));		//r2c1
-			r2c2 = *(imgin_ptr+(((H_ROW_WIDTH*(i+1))+(j+1))));	//r2c2
+			r1c1 = *(imgin_ptr+(((h_row_width*i)+j)));		//r1c1
+			r1c2 = *(imgin_ptr+(((h_row_width*i)+(j+1))));		//r1c2
+			r2c1 = *(imgin_ptr+(((h_row_width*(i+1))+j)));		//r2c1
+			r2c2 = *(imgin_ptr+(((h_row_width*(i+1))+(j+1))));	//r2c2
 			
 			/*
 			** input buffer
@@ -1252,11 +2263,11 @@ int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr)
 			/*ll*/
 			*(imgout_ptr+(quad_row_offset+k))=rgb565_ll;
 			/*lh*/	
-			*(imgout_ptr+(QUAD_COL_OFFSET+(quad_row_offset+k)))=rgb565_lh;
+			*(imgout_ptr+(quad_col_offset+(quad_row_offset+k)))=rgb565_lh;
 			/*hl*/
-			*(imgout_ptr+((QUAD_ROW_ORIGIN)+(quad_row_offset+k)))=rgb565_hl;
+			*(imgout_ptr+((quad_row_origin)+(quad_row_offset+k)))=rgb565_hl;
 			/*hh*/
-			*(imgout_ptr+((QUAD_ROW_ORIGIN)+QUAD_COL_OFFSET+(quad_row_offset+k)))=rgb565_hh;			
+			*(imgout_ptr+((quad_row_origin)+quad_col_offset+(quad_row_offset+k)))=rgb565_hh;			
 			
 			/*
 			** output buffer
@@ -1282,7 +2293,4475 @@ int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr)
 
 	return(0);
 
+}/*eo haar_dwt*/
+
+/*
+** HaarDwt
+** haar dwt of a cap_geo rgb565 frame
+*/
+int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr)
+{
+
+	GEO_SPECIALIZE(&cap_geo, haar_dwt, imgin_ptr, imgout_ptr);
+
+	return(0);
+
 }/*eo HaarDwt*/
 
+/*
+** grayscale (luma only) path
+** the Y samples of the yuyv422 frame form an 8 bit image, its haar dwt
+** runs on one channel instead of three and the display stage expands the
+** result to grey rgb565. luma pixels are in the order convert2() writes
+** them, Y0 (byte 2 of the macropixel) before Y1 (byte 0).
+*/
+static inline __attribute__((always_inline)) 
+void luma_rows(int width, int height, uint8_t *yuvptr, uint8_t *grayptr){
+
+	const int stride = cap_geo.stride;
+	int x=0, y=0;
+
+	for(y=0; y<height; y++){
+		for(x=0; x<width; x+=2){
+			grayptr[x] = yuvptr[2*x + 2];		/*Y0*/
+			grayptr[x+1] = yuvptr[2*x];		/*Y1*/
+		}/*eo for*/
+		yuvptr += stride;
+		grayptr += width;
+	}/*eo for*/
+
+}/*eo luma_rows*/
+
+/*
+** LumaExtract
+** copy the luma of a cap_geo yuyv422 frame into a width x height 8 bit
+** frame
+*/
+int LumaExtract(void *cbp, uint8_t *grayptr){
+
+	GEO_SPECIALIZE(&cap_geo, luma_rows, (uint8_t *)cbp, grayptr);
+
+	return(0);
+
+}/*eo LumaExtract*/
+
+/*
+** haar_gray_rows
+** HaarDwt arithmetic on one 8 bit channel for the rows r1 and r2: ll is
+** the mean of the 2x2 window, the detail quadrants the halved differences
+** with the x10 gain, saturated at 255 where the rgb565 channels keep only
+** their low bits. restrict lets the compiler vectorize the loop.
+*/
+static inline void haar_gray_rows(const uint8_t *restrict r1, 
+				  const uint8_t *restrict r2, 
+				  uint8_t *restrict ll, uint8_t *restrict lh,
+				  uint8_t *restrict hl, uint8_t *restrict hh,
+				  int half){
+
+	uint8_t a=0, b=0, c=0, d=0, lp1=0, lp2=0, hp1=0, hp2=0, v=0;
+	int k=0;
+
+	for(k=0; k<half; k++){
+		a = r1[2*k]; b = r1[2*k+1];
+		c = r2[2*k]; d = r2[2*k+1];
+
+		lp1 = (a+c) >> 1;
+		lp2 = (b+d) >> 1;
+		ll[k] = (lp1+lp2) >> 1;
+
+		v = (lp1 > lp2 ? lp1-lp2 : lp2-lp1) >> 1;
+		lh[k] = v > 25 ? 255 : v*10;
+
+		hp1 = (a > c ? a-c : c-a) >> 1;
+		hp2 = (b > d ? b-d : d-b) >> 1;
+		v = (hp1+hp2) >> 1;
+		hl[k] = v > 25 ? 255 : v*10;
+
+		v = (hp1 > hp2 ? hp1-hp2 : hp2-hp1) >> 1;
+		hh[k] = v > 25 ? 255 : v*10;
+	}/*eo for*/
+
+}/*eo haar_gray_rows*/
+
+/*
+** haar_dwt_gray
+** quadrants laid out as in HaarDwt
+*/
+static inline __attribute__((always_inline)) 
+void haar_dwt_gray(int width, int height, const uint8_t *in, uint8_t *out){
+
+	const int half = width/2;
+	uint8_t *ll=NULL;
+	int i=0;
+
+	for(i=0; i<height; i+=2){
+		ll = out + (i/2)*width;
+		haar_gray_rows(in + i*width, in + (i+1)*width, ll, ll + half, 
+			       ll + (height/2)*width, ll + (height/2)*width + half,
+			       half);
+	}/*eo for*/
+
+}/*eo haar_dwt_gray*/
+
+/*
+** HaarDwtGray
+** haar dwt of a cap_geo 8 bit luma frame into an 8 bit frame
+*/
+int HaarDwtGray(uint8_t *imgin_ptr, uint8_t *imgout_ptr){
+
+	GEO_SPECIALIZE(&cap_geo, haar_dwt_gray, imgin_ptr, imgout_ptr);
+
+	return(0);
+
+}/*eo HaarDwtGray*/
+
+/*
+** display_gray
+** expand a cap_geo 8 bit frame to grey rgb565 in the centre of the 
+** framebuffer, a row at a time through the blit engine
+*/
+static void gray_row(uint16_t *restrict line, const uint8_t *restrict gray,
+		     int width){
+
+	int x=0, v=0;
+
+	for(x=0; x<width; x++){
+		v = gray[x];
+		line[x] = ((v >> 3) << 11) | ((v >> 2) << 5) | (v >> 3);
+	}/*eo for*/
+
+}/*eo gray_row*/
+
+int display_gray(void *fbp, uint8_t *gray){
+
+	uint16_t line[MAX_FRAME_WIDTH];
+	struct blit_area a;
+	uint16_t *d=NULL;
+	int y=0;
+
+	if(blit_clip(fbp, NULL, cap_geo.width, cap_geo.height, &a) < 0)
+		return(-1);
+
+	gray += (long)a.sy*cap_geo.width + a.sx;
+	d = a.dst;
+	for(y=0; y<a.height; y++){
+		gray_row(line, gray, a.width);
+		blit_row(d, line, a.width);
+		d += finfo.line_length/2;
+		gray += cap_geo.width;
+	}/*eo for*/
+	blit_flush();
+	osd_damage(a.y, a.height);
+
+	return(0);
+
+}/*eo display_gray*/
+
+/*
+** fixed point scaler
+** a cap_geo rgb565 frame is scaled to any size on its way into the 
+** framebuffer, there is no scaled frame in memory. every destination
+** column and row has its source index and, for bilinear, a 5 bit weight
+** of the next source pixel (SCALE_FRAC), made once by scale_init(). the
+** rows of a band are built in line buffers and written with blit_row:
+** nearest picks the pixels, bilinear blends two source pixels in each
+** row (scale_hrow, kept for the next destination rows) and the two rows
+** with the simd scale_vblend. 5 bits is all a 5 or 6 bit channel needs.
+*/
+
+/*
+** rgb565 spread over 32 bits with room for a 5 bit weight above every
+** channel: green in bits 21..26, red 11..15, blue 0..4
+*/
+static inline uint32_t rgb565_spread(uint16_t p){
+
+	return((p | (uint32_t)p << 16) & 0x07e0f81f);
+
+}/*eo rgb565_spread*/
+
+static inline uint16_t rgb565_lerp(uint16_t a, uint16_t b, int w){
+
+	uint32_t c = (rgb565_spread(a)*(SCALE_ONE - w) + rgb565_spread(b)*w) 
+		>> SCALE_FRAC & 0x07e0f81f;
+
+	return(c | c >> 16);
+
+}/*eo rgb565_lerp*/
+
+static void scale_vblend_scalar(uint16_t *restrict dst, 
+				const uint16_t *restrict r0, 
+				const uint16_t *restrict r1, int w, 
+				int npixels){
+
+	int x=0;
+
+	for(x=0; x<npixels; x++)
+		dst[x] = rgb565_lerp(r0[x], r1[x], w);
+
+}/*eo scale_vblend_scalar*/
+
+void (*scale_vblend)(uint16_t *dst, const uint16_t *r0, const uint16_t *r1,
+		     int w, int npixels) = scale_vblend_scalar;
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/*
+** eight pixels, every channel in its own 16 bit lane: (a*(32-w) + b*w)
+** >> 5 needs at most 11 bits and is the same floor as rgb565_lerp()
+*/
+static inline __m128i vblend_sse2(__m128i a, __m128i b, __m128i wa, 
+				  __m128i wb){
+
+	const __m128i g6 = _mm_set1_epi16(0x3f), b5 = _mm_set1_epi16(0x1f);
+	__m128i r, g, bl;
+
+	r = _mm_add_epi16(_mm_mullo_epi16(_mm_srli_epi16(a, 11), wa), 
+			  _mm_mullo_epi16(_mm_srli_epi16(b, 11), wb));
+	g = _mm_add_epi16(
+		_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(a, 5), g6), wa),
+		_mm_mullo_epi16(_mm_and_si128(_mm_srli_epi16(b, 5), g6), wb));
+	bl = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(a, b5), wa), 
+			   _mm_mullo_epi16(_mm_and_si128(b, b5), wb));
+
+	return(_mm_or_si128(_mm_or_si128(
+		_mm_slli_epi16(_mm_srli_epi16(r, SCALE_FRAC), 11), 
+		_mm_slli_epi16(_mm_srli_epi16(g, SCALE_FRAC), 5)), 
+		_mm_srli_epi16(bl, SCALE_FRAC)));
+
+}/*eo vblend_sse2*/
+
+static void scale_vblend_sse2(uint16_t *restrict dst, 
+			      const uint16_t *restrict r0, 
+			      const uint16_t *restrict r1, int w, 
+			      int npixels){
+
+	const __m128i wa = _mm_set1_epi16(SCALE_ONE - w);
+	const __m128i wb = _mm_set1_epi16(w);
+	int x=0;
+
+	for(x=0; x+8<=npixels; x+=8)
+		_mm_storeu_si128((__m128i *)(dst + x), vblend_sse2(
+			_mm_loadu_si128((const __m128i *)(r0 + x)), 
+			_mm_loadu_si128((const __m128i *)(r1 + x)), wa, wb));
+	for(; x<npixels; x++)
+		dst[x] = rgb565_lerp(r0[x], r1[x], w);
+
+}/*eo scale_vblend_sse2*/
+
+__attribute__((target("avx2")))
+static void scale_vblend_avx2(uint16_t *restrict dst, 
+			      const uint16_t *restrict r0, 
+			      const uint16_t *restrict r1, int w, 
+			      int npixels){
+
+	const __m256i wa = _mm256_set1_epi16(SCALE_ONE - w);
+	const __m256i wb = _mm256_set1_epi16(w);
+	const __m256i g6 = _mm256_set1_epi16(0x3f), b5 = _mm256_set1_epi16(0x1f);
+	__m256i a, b, r, g, bl;
+	int x=0;
+
+	for(x=0; x+16<=npixels; x+=16){
+		a = _mm256_loadu_si256((const __m256i *)(r0 + x));
+		b = _mm256_loadu_si256((const __m256i *)(r1 + x));
+		r = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_srli_epi16(a, 11), wa), 
+			_mm256_mullo_epi16(_mm256_srli_epi16(b, 11), wb));
+		g = _mm256_add_epi16(_mm256_mullo_epi16(
+			_mm256_and_si256(_mm256_srli_epi16(a, 5), g6), wa),
+			_mm256_mullo_epi16(
+			_mm256_and_si256(_mm256_srli_epi16(b, 5), g6), wb));
+		bl = _mm256_add_epi16(
+			_mm256_mullo_epi16(_mm256_and_si256(a, b5), wa), 
+			_mm256_mullo_epi16(_mm256_and_si256(b, b5), wb));
+		_mm256_storeu_si256((__m256i *)(dst + x), 
+			_mm256_or_si256(_mm256_or_si256(
+			_mm256_slli_epi16(_mm256_srli_epi16(r, SCALE_FRAC), 11),
+			_mm256_slli_epi16(_mm256_srli_epi16(g, SCALE_FRAC), 5)),
+			_mm256_srli_epi16(bl, SCALE_FRAC)));
+	}/*eo for*/
+	if(x < npixels)
+		scale_vblend_sse2(dst + x, r0 + x, r1 + x, w, npixels - x);
+
+}/*eo scale_vblend_avx2*/
+
+#endif /*x86*/
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+static void scale_vblend_neon(uint16_t *restrict dst, 
+			      const uint16_t *restrict r0, 
+			      const uint16_t *restrict r1, int w, 
+			      int npixels){
+
+	const uint16x8_t g6 = vdupq_n_u16(0x3f), b5 = vdupq_n_u16(0x1f);
+	uint16x8_t a, b, r, g, bl;
+	int x=0;
+
+	for(x=0; x+8<=npixels; x+=8){
+		a = vld1q_u16(r0 + x);
+		b = vld1q_u16(r1 + x);
+		r = vmlaq_n_u16(vmulq_n_u16(vshrq_n_u16(a, 11), SCALE_ONE - w), 
+				vshrq_n_u16(b, 11), w);
+		g = vmlaq_n_u16(vmulq_n_u16(vandq_u16(vshrq_n_u16(a, 5), g6), 
+					    SCALE_ONE - w), 
+				vandq_u16(vshrq_n_u16(b, 5), g6), w);
+		bl = vmlaq_n_u16(vmulq_n_u16(vandq_u16(a, b5), SCALE_ONE - w), 
+				 vandq_u16(b, b5), w);
+		vst1q_u16(dst + x, vorrq_u16(vorrq_u16(
+			vshlq_n_u16(vshrq_n_u16(r, SCALE_FRAC), 11),
+			vshlq_n_u16(vshrq_n_u16(g, SCALE_FRAC), 5)),
+			vshrq_n_u16(bl, SCALE_FRAC)));
+	}/*eo for*/
+	for(; x<npixels; x++)
+		dst[x] = rgb565_lerp(r0[x], r1[x], w);
+
+}/*eo scale_vblend_neon*/
+
+#endif /*neon*/
+
+/*
+** scale_index
+** source index and next pixel weight of destination pixel i of n taken
+** from src source pixels, centres aligned. bilinear indices stop one
+** short of the last pixel so the next one always exists.
+*/
+static void scale_index(int i, int n, int src, int mode, int32_t *idx, 
+			uint8_t *w){
+
+	int64_t pos = ((int64_t)(2*i + 1)*src << 16)/(2*n) - (1 << 15);
+
+	if(mode == SCALE_NEAREST){
+		*idx = ((int64_t)(2*i + 1)*src)/(2*n);
+		*w = 0;
+		return;
+	}/*eo if*/
+
+	if(pos < 0) pos = 0;
+	*idx = pos >> 16;
+	*w = (pos >> (16 - SCALE_FRAC)) & (SCALE_ONE - 1);
+	if(*idx >= src - 1){
+		*idx = src - 2;
+		*w = SCALE_ONE;
+	}/*eo if*/
+
+}/*eo scale_index*/
+
+/*
+** scale_init
+** tables for scaling src_width x src_height frames to width x height,
+** both at least 2x2 and at most MAX_FRAME_WIDTH wide
+*/
+int scale_init(struct scaler *s, int mode, int src_width, int src_height,
+	       int width, int height){
+
+	int i=0;
+
+	memset(s, 0, sizeof(*s));
+	if(src_width < 2 || src_height < 2 || width < 2 || height < 2 ||
+	   src_width > MAX_FRAME_WIDTH || width > MAX_FRAME_WIDTH ||
+	   (mode != SCALE_NEAREST && mode != SCALE_BILINEAR))
+		return(-1);
+
+	s->mode = mode;
+	s->src_width = src_width;
+	s->src_height = src_height;
+	s->width = width;
+	s->height = height;
+	s->xi = malloc(width*sizeof(int32_t));
+	s->xw = malloc(width);
+	s->yi = malloc(height*sizeof(int32_t));
+	s->yw = malloc(height);
+	if(s->xi == NULL || s->xw == NULL || s->yi == NULL || s->yw == NULL){
+		scale_free(s);
+		return(-1);
+	}/*eo if*/
+
+	for(i=0; i<width; i++)
+		scale_index(i, width, src_width, mode, &s->xi[i], &s->xw[i]);
+	for(i=0; i<height; i++)
+		scale_index(i, height, src_height, mode, &s->yi[i], &s->yw[i]);
+
+	return(0);
+
+}/*eo scale_init*/
+
+void scale_free(struct scaler *s){
+
+	free(s->xi);
+	free(s->xw);
+	free(s->yi);
+	free(s->yw);
+	s->xi = s->yi = NULL;
+	s->xw = s->yw = NULL;
+
+}/*eo scale_free*/
+
+/*
+** one destination row from one source row
+*/
+static void scale_hrow(struct scaler *s, uint16_t *restrict line, 
+		       const uint16_t *restrict src){
+
+	const int32_t *xi = s->xi;
+	const uint8_t *xw = s->xw;
+	int x=0;
+
+	if(s->mode == SCALE_NEAREST){
+		for(x=0; x<s->width; x++)
+			line[x] = src[xi[x]];
+		return;
+	}/*eo if*/
+
+	for(x=0; x<s->width; x++)
+		line[x] = rgb565_lerp(src[xi[x]], src[xi[x] + 1], xw[x]);
+
+}/*eo scale_hrow*/
+
+/*
+** scale job, a band of destination rows per thread. h0 and h1 hold the
+** scaled source rows c0 and c1 so an upscaled row is made only once.
+*/
+struct scale_job {
+	struct scaler *s;
+	const uint8_t *src;
+	int src_stride;
+	uint16_t *dst;
+};
+
+static void scale_band(void *arg, int band, int nbands){
+
+	struct scale_job *job = arg;
+	struct scaler *s = job->s;
+	uint16_t buf0[MAX_FRAME_WIDTH], buf1[MAX_FRAME_WIDTH];
+	uint16_t line[MAX_FRAME_WIDTH];
+	uint16_t *h0=buf0, *h1=buf1, *t=NULL, *d=NULL;
+	int first = s->height*band/nbands, last = s->height*(band+1)/nbands;
+	int y=0, sy=0, c0=-1, c1=-1;
+
+	for(y=first; y<last; y++){
+
+		d = job->dst + (long)y*(finfo.line_length/2);
+		sy = s->yi[y];
+
+		/*
+		** the upper source row, often the lower one of the last
+		** destination row
+		*/
+		if(sy != c0){
+			if(sy == c1){
+				t = h0; h0 = h1; h1 = t;
+				c0 = c1;
+				c1 = -1;
+			}else{
+				scale_hrow(s, h0, (const uint16_t *)
+					   (job->src + (long)sy*job->src_stride));
+				c0 = sy;
+			}/*eo if*/
+		}/*eo if*/
+		if(s->yw[y] == 0){
+			blit_row(d, h0, s->width);
+			continue;
+		}/*eo if*/
+
+		if(c1 != sy + 1){
+			scale_hrow(s, h1, (const uint16_t *)
+				   (job->src + (long)(sy + 1)*job->src_stride));
+			c1 = sy + 1;
+		}/*eo if*/
+		if(s->yw[y] == SCALE_ONE){
+			blit_row(d, h1, s->width);
+			continue;
+		}/*eo if*/
+		scale_vblend(line, h0, h1, s->yw[y], s->width);
+		blit_row(d, line, s->width);
+
+	}/*eo for*/
+	blit_flush();
+
+}/*eo scale_band*/
+
+/*
+** scale_rgb565
+** scale a frame with a line length of src_stride bytes straight into the
+** centre of region r of the framebuffer (NULL for all of it), in row 
+** bands over the worker pool. the pipelined display stage runs it 
+** alone, the pool belongs to the process stage there.
+*/
+int scale_rgb565(struct scaler *s, void *fbp, const struct region *r, 
+		 const void *src, int src_stride){
+
+	struct scale_job job = { s, src, src_stride, NULL };
+	struct blit_area a;
+
+	if(blit_clip(fbp, r, s->width, s->height, &a) < 0 || 
+	   a.width != s->width || a.height != s->height)
+		return(-1);
+	job.dst = a.dst;
+	osd_damage(a.y, a.height);
+
+	if(pipeline)
+		scale_band(&job, 0, 1);
+	else
+		pool_run(scale_band, &job);
+
+	return(0);
+
+}/*eo scale_rgb565*/
+
+/*
+** scale_fit
+** largest size with the aspect ratio of a src_width x src_height frame
+** that fits in *width x *height
+*/
+void scale_fit(int src_width, int src_height, int *width, int *height){
+
+	if((long)src_width**height > (long)src_height**width)
+		*height = (long)src_height**width/src_width;
+	else
+		*width = (long)src_width**height/src_height;
+
+}/*eo scale_fit*/
+
+/*
+** scale_parse
+** -z nearest|bilinear[,stretch]
+*/
+int scale_parse(char *spec){
+
+	char *fit = strchr(spec, ',');
+	int n = fit ? fit - spec : (int)strlen(spec);
+
+	if(n == 7 && strncmp(spec, "nearest", n) == 0)
+		scale = SCALE_NEAREST;
+	else if(n == 8 && strncmp(spec, "bilinear", n) == 0)
+		scale = SCALE_BILINEAR;
+	else
+		return(-1);
+	if(fit && strcmp(fit + 1, "stretch") != 0)
+		return(-1);
+	scale_stretch = fit != NULL;
+
+	return(0);
+
+}/*eo scale_parse*/
+
+/*
+** multi-view compositor
+** a layout puts one or two views of the frame into regions of the
+** visible framebuffer: the converted (raw) frame, the haar dwt frame
+** with its four quadrants, or one dwt subband zoomed to the region. a
+** view goes from its frame straight into its region, 1:1 through 
+** blit_rgb565 where it fits and is not scaled, otherwise through its own
+** scaler (-z mode, nearest without one). compose_layout() makes the 
+** regions and scalers, only when the layout changes. a layout that 
+** cannot be made leaves the one in use as it was.
+*/
+char *view_layouts[NVIEW_LAYOUTS] = { "dwt", "raw", "split", "zoom" };
+char *view_bands[4] = { "ll", "lh", "hl", "hh" };
+
+void compose_free(struct compositor *c){
+
+	int i=0;
+
+	for(i=0; i<c->nviews; i++)
+		if(c->v[i].scaled)
+			scale_free(&c->v[i].s);
+	c->nviews = 0;
+
+}/*eo compose_free*/
+
+/*
+** compose_layout
+** regions and scalers of a layout for cap_geo frames, band is the 
+** zoomed subband. mode 0 shows the views that fit 1:1, stretch fills 
+** the regions without keeping the aspect ratio. the layout is made in
+** a new compositor that replaces c only once all of it is there, on 
+** failure c is untouched.
+*/
+int compose_layout(struct compositor *c, int layout, int band, int mode,
+		   int stretch){
+
+	struct compositor n = { .layout = layout, .band = band };
+	struct view *v=NULL;
+	int i=0, sw=0, sh=0, w=0, h=0, half=vinfo.xres/2;
+
+	switch(layout){
+	case VIEW_RAW:
+		n.nviews = 1;
+		n.v[0] = (struct view){ .src = VIEW_SRC_RAW, .band = -1 };
+		break;
+	case VIEW_SPLIT:
+		n.nviews = 2;
+		n.v[0] = (struct view){ .src = VIEW_SRC_RAW, .band = -1, 
+			 .r = { .x = 0, .y = 0, .width = half, 
+				.height = vinfo.yres } };
+		n.v[1] = (struct view){ .src = VIEW_SRC_DWT, .band = -1, 
+			 .r = { .x = half, .y = 0, .width = vinfo.xres - half,
+				.height = vinfo.yres } };
+		break;
+	case VIEW_ZOOM:
+		n.nviews = 1;
+		n.v[0] = (struct view){ .src = VIEW_SRC_DWT, .band = band };
+		break;
+	default:
+		n.nviews = 1;
+		n.v[0] = (struct view){ .src = VIEW_SRC_DWT, .band = -1 };
+		break;
+	}/*eo switch*/
+
+	for(i=0; i<n.nviews; i++){
+		v = &n.v[i];
+		if(n.nviews == 1)
+			v->r = (struct region){ .x = 0, .y = 0, 
+				.width = vinfo.xres, .height = vinfo.yres };
+		sw = v->band < 0 ? cap_geo.width : cap_geo.width/2;
+		sh = v->band < 0 ? cap_geo.height : cap_geo.height/2;
+		w = v->r.width;
+		h = v->r.height;
+		if(!stretch)
+			scale_fit(sw, sh, &w, &h);
+
+		/*
+		** 1:1 if it fits and nothing asks for scaling
+		*/
+		v->scaled = 0;
+		if((!mode && v->band < 0 && sw <= v->r.width && 
+		    sh <= v->r.height) || (w == sw && h == sh))
+			continue;
+		if(scale_init(&v->s, mode ? mode : SCALE_NEAREST, sw, sh, w, h) 
+		   < 0){
+			n.nviews = i;
+			compose_free(&n);
+			return(-1);
+		}/*eo if*/
+		v->scaled = 1;
+	}/*eo for*/
+
+	compose_free(c);
+	*c = n;
+
+	return(0);
+
+}/*eo compose_layout*/
+
+/*
+** compose
+** every view of the layout from the raw or dwt cap_geo frame into its
+** region
+*/
+int compose(struct compositor *c, void *fbp, const uint16_t *raw, 
+	    const uint16_t *dwt){
+
+	struct view *v=NULL;
+	const uint16_t *src=NULL;
+	int i=0, ret=0, w=cap_geo.width, h=cap_geo.height;
+
+	for(i=0; i<c->nviews; i++){
+		v = &c->v[i];
+		src = v->src == VIEW_SRC_RAW ? raw : dwt;
+		if(v->band >= 0)
+			src += (v->band & 2 ? (h/2)*w : 0) + (v->band & 1 ? w/2 : 0);
+		if(v->scaled)
+			ret |= scale_rgb565(&v->s, fbp, &v->r, src, w*2);
+		else
+			ret |= blit_rgb565(fbp, &v->r, src, v->band < 0 ? w : w/2, 
+					   v->band < 0 ? h : h/2, w*2);
+	}/*eo for*/
+
+	return(ret);
+
+}/*eo compose*/
+
+/*
+** view_parse
+** -V dwt|raw|split|zoom[,ll|lh|hl|hh]
+*/
+int view_parse(char *spec){
+
+	char *band = strchr(spec, ',');
+	int n = band ? band - spec : (int)strlen(spec);
+	int i=0;
+
+	for(i=0; i<NVIEW_LAYOUTS; i++)
+		if((int)strlen(view_layouts[i]) == n && 
+		   strncmp(spec, view_layouts[i], n) == 0)
+			break;
+	if(i == NVIEW_LAYOUTS)
+		return(-1);
+	view_layout = i;
+	if(band){
+		for(i=0; i<4; i++)
+			if(strcmp(band + 1, view_bands[i]) == 0)
+				break;
+		if(i == 4)
+			return(-1);
+		view_band = i;
+	}/*eo if*/
+	views = 1;
+
+	return(0);
+
+}/*eo view_parse*/
+
+/*
+** telemetry overlay
+** up to OSD_LINES lines of OSD_COLS characters in the top left corner
+** of the visible area, 5x7 glyphs in 6x8 cells, doubled from 1280 
+** pixels wide. every page keeps the characters its cells show and only
+** cells whose character changed are drawn. osd_damage() is told which
+** rows the video wrote and makes the cells it covered dirty again. a 
+** draw stops at its microsecond budget, the cells left stay dirty for
+** the next frame.
+*/
+static const uint8_t osd_font[][5] = {	/*columns, bit 0 at the top*/
+	['%' - ' '] = { 0x23, 0x13, 0x08, 0x64, 0x62 },
+	['-' - ' '] = { 0x08, 0x08, 0x08, 0x08, 0x08 },
+	['.' - ' '] = { 0x00, 0x60, 0x60, 0x00, 0x00 },
+	['/' - ' '] = { 0x20, 0x10, 0x08, 0x04, 0x02 },
+	['0' - ' '] = { 0x3e, 0x51, 0x49, 0x45, 0x3e },
+	['1' - ' '] = { 0x00, 0x42, 0x7f, 0x40, 0x00 },
+	['2' - ' '] = { 0x42, 0x61, 0x51, 0x49, 0x46 },
+	['3' - ' '] = { 0x21, 0x41, 0x45, 0x4b, 0x31 },
+	['4' - ' '] = { 0x18, 0x14, 0x12, 0x7f, 0x10 },
+	['5' - ' '] = { 0x27, 0x45, 0x45, 0x45, 0x39 },
+	['6' - ' '] = { 0x3c, 0x4a, 0x49, 0x49, 0x30 },
+	['7' - ' '] = { 0x01, 0x71, 0x09, 0x05, 0x03 },
+	['8' - ' '] = { 0x36, 0x49, 0x49, 0x49, 0x36 },
+	['9' - ' '] = { 0x06, 0x49, 0x49, 0x29, 0x1e },
+	[':' - ' '] = { 0x00, 0x36, 0x36, 0x00, 0x00 },
+	['A' - ' '] = { 0x7e, 0x11, 0x11, 0x11, 0x7e },
+	['B' - ' '] = { 0x7f, 0x49, 0x49, 0x49, 0x36 },
+	['C' - ' '] = { 0x3e, 0x41, 0x41, 0x41, 0x22 },
+	['D' - ' '] = { 0x7f, 0x41, 0x41, 0x22, 0x1c },
+	['E' - ' '] = { 0x7f, 0x49, 0x49, 0x49, 0x41 },
+	['F' - ' '] = { 0x7f, 0x09, 0x09, 0x09, 0x01 },
+	['G' - ' '] = { 0x3e, 0x41, 0x49, 0x49, 0x7a },
+	['H' - ' '] = { 0x7f, 0x08, 0x08, 0x08, 0x7f },
+	['I' - ' '] = { 0x00, 0x41, 0x7f, 0x41, 0x00 },
+	['J' - ' '] = { 0x20, 0x40, 0x41, 0x3f, 0x01 },
+	['K' - ' '] = { 0x7f, 0x08, 0x14, 0x22, 0x41 },
+	['L' - ' '] = { 0x7f, 0x40, 0x40, 0x40, 0x40 },
+	['M' - ' '] = { 0x7f, 0x02, 0x0c, 0x02, 0x7f },
+	['N' - ' '] = { 0x7f, 0x04, 0x08, 0x10, 0x7f },
+	['O' - ' '] = { 0x3e, 0x41, 0x41, 0x41, 0x3e },
+	['P' - ' '] = { 0x7f, 0x09, 0x09, 0x09, 0x06 },
+	['Q' - ' '] = { 0x3e, 0x41, 0x51, 0x21, 0x5e },
+	['R' - ' '] = { 0x7f, 0x09, 0x19, 0x29, 0x46 },
+	['S' - ' '] = { 0x46, 0x49, 0x49, 0x49, 0x31 },
+	['T' - ' '] = { 0x01, 0x01, 0x7f, 0x01, 0x01 },
+	['U' - ' '] = { 0x3f, 0x40, 0x40, 0x40, 0x3f },
+	['V' - ' '] = { 0x1f, 0x20, 0x40, 0x20, 0x1f },
+	['W' - ' '] = { 0x3f, 0x40, 0x38, 0x40, 0x3f },
+	['X' - ' '] = { 0x63, 0x14, 0x08, 0x14, 0x63 },
+	['Y' - ' '] = { 0x07, 0x08, 0x70, 0x08, 0x07 },
+	['Z' - ' '] = { 0x61, 0x51, 0x49, 0x45, 0x43 },
+};
+#define OSD_GLYPHS	(int)(sizeof(osd_font)/sizeof(osd_font[0]))
+
+static char osd_text[OSD_LINES][OSD_COLS];
+static char osd_shown[2][OSD_LINES][OSD_COLS];	/*per page, 0 = not drawn*/
+
+/*
+** glyph columns of a character, lower case is shown as upper case and
+** anything without a glyph as a space
+*/
+const uint8_t *osd_glyph(int c){
+
+	if(c >= 'a' && c <= 'z')
+		c -= 'a' - 'A';
+	if(c < ' ' || c - ' ' >= OSD_GLYPHS)
+		c = ' ';
+
+	return(osd_font[c - ' ']);
+
+}/*eo osd_glyph*/
+
+/*
+** cell size in pixels and the first text row and column of the 
+** visible area
+*/
+int osd_zoom(void){
+
+	return(vinfo.xres >= 1280 ? 2 : 1);
+
+}/*eo osd_zoom*/
+
+int osd_top(void){
+
+	return(2*osd_zoom());
+
+}/*eo osd_top*/
+
+/*
+** osd_printf
+** set one line of text, it is drawn by the next osd_draw()
+*/
+void osd_printf(int line, const char *fmt, ...){
+
+	char buf[OSD_COLS + 1];
+	va_list ap;
+	int i=0;
+
+	if(line < 0 || line >= OSD_LINES)
+		return;
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+	for(i=0; i<OSD_COLS && buf[i]; i++)
+		osd_text[line][i] = buf[i];
+	for(; i<OSD_COLS; i++)
+		osd_text[line][i] = ' ';
+
+}/*eo osd_printf*/
+
+/*
+** osd_damage
+** rows y .. y+height-1 of the visible area in the page being drawn were
+** overwritten, the text cells on them have to be drawn again
+*/
+void osd_damage(int y, int height){
+
+	int page = dbuf && fb_back ? 1 : 0;
+	int cell = 8*osd_zoom(), top = osd_top(), line=0;
+
+	for(line=0; line<OSD_LINES; line++)
+		if(y < top + (line + 1)*cell && y + height > top + line*cell)
+			memset(osd_shown[page][line], 0, OSD_COLS);
+
+}/*eo osd_damage*/
+
+void osd_invalidate(void){
+
+	memset(osd_shown, 0, sizeof(osd_shown));
+
+}/*eo osd_invalidate*/
+
+/*
+** one character cell, white on black
+*/
+static void osd_cell(uint16_t *d, int c, int zoom){
+
+	const uint8_t *g = osd_glyph(c);
+	uint16_t row[12];
+	int x=0, y=0, z=0, stride = finfo.line_length/2;
+
+	for(y=0; y<8; y++){
+		for(x=0; x<6*zoom; x++)
+			row[x] = x/zoom < 5 && (g[x/zoom] >> y & 1) ? WHITE : BLACK;
+		for(z=0; z<zoom; z++){
+			memcpy(d, row, 6*zoom*sizeof(uint16_t));
+			d += stride;
+		}/*eo for*/
+	}/*eo for*/
+
+}/*eo osd_cell*/
+
+/*
+** osd_draw
+** draw the cells of the page being drawn whose character changed or 
+** was overwritten, until budget_us is spent, checked before every 
+** cell. returns the number of cells drawn.
+*/
+int osd_draw(void *fbp, int budget_us){
+
+	struct timespec t0, t1;
+	int page = dbuf && fb_back ? 1 : 0;
+	int zoom = osd_zoom(), line=0, col=0, n=0;
+	int cols = (vinfo.xres - osd_top())/(6*zoom);
+	uint16_t *d=NULL;
+
+	if(fbp == NULL || vinfo.yres < (unsigned)(osd_top() + OSD_LINES*8*zoom))
+		return(0);
+	if(cols > OSD_COLS)
+		cols = OSD_COLS;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for(line=0; line<OSD_LINES; line++){
+		d = (uint16_t *)((uint8_t *)fbp + 
+			((long)(dbuf ? fb_back : vinfo.yoffset) + osd_top() + 
+			 line*8*zoom)*finfo.line_length) + vinfo.xoffset + 
+			osd_top();
+		for(col=0; col<cols; col++){
+			if(osd_shown[page][line][col] == osd_text[line][col])
+				continue;
+
+			/*
+			** the rest waits for the next frame, a cell at least
+			** is drawn every frame
+			*/
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			if(n > 0 && ((t1.tv_sec - t0.tv_sec)*1000000 + 
+			   (t1.tv_nsec - t0.tv_nsec)/1000 >= budget_us))
+				return(n);
+			osd_cell(d + col*6*zoom, osd_text[line][col], zoom);
+			osd_shown[page][line][col] = osd_text[line][col];
+			n++;
+		}/*eo for*/
+	}/*eo for*/
+
+	return(n);
+
+}/*eo osd_draw*/
+
+/*
+** integer haar lifting (S-transform)
+** a reversible haar transform on planar int16 frames. for a pair a, b
+** the detail is d = a - b and the smooth value s = b + (d >> 1), the
+** floor of the mean. rows are lifted, then columns, then the smooth
+** (LL) quadrant again for every further level. the coefficients stay in
+** the plane at full precision in the HaarDwt quadrant layout: LL top 
+** left, horizontal detail top right, vertical bottom left and diagonal
+** bottom right. only two rows of line buffer are used besides the plane.
+** smooth values keep the range of the input, details of 8 bit input 
+** stay within +-510, so the int16 lanes hold any depth. the inverse runs
+** the same steps backwards from the deepest level, b = s - (d >> 1),
+** a = d + b, and gives back the input exactly.
+*/
+
+/*
+** lift_levels
+** number of levels a width x height frame allows, every level needs an
+** even width and height
+*/
+int lift_levels(int width, int height, int levels){
+
+	int n=0;
+
+	if(levels > LIFT_MAX_LEVELS) levels = LIFT_MAX_LEVELS;
+	while(n < levels && width >= 2 && height >= 2 && 
+	      (width & 1) == 0 && (height & 1) == 0){
+		width /= 2;
+		height /= 2;
+		n++;
+	}/*eo while*/
+
+	return(n);
+
+}/*eo lift_levels*/
+
+/*
+** shrink
+** threshold a detail coefficient: hard zeroes it within +-t, soft also
+** moves the rest t towards zero. t = 0 leaves it as it is.
+*/
+enum { SHRINK_NONE, SHRINK_HARD, SHRINK_SOFT };
+
+static inline __attribute__((always_inline)) 
+int16_t shrink(int16_t v, int16_t t, const int mode){
+
+	if(mode == SHRINK_HARD)
+		return(v > t || v < -t ? v : 0);
+	if(mode == SHRINK_SOFT)
+		return(v > t ? v - t : v < -t ? v + t : 0);
+
+	return(v);
+
+}/*eo shrink*/
+
+/*
+** lift_quad
+** one level on a pair of rows in a single pass: every 2x2 window is
+** lifted along the rows and then down the columns, the details are
+** shrunk on the way out. l1 gets LL | HL and l2 LH | HH, in place the
+** caller copies them back to r1 and r2. lift_span does the windows from
+** k on, the simd kernels use it for their tails.
+*/
+static inline __attribute__((always_inline)) 
+void lift_span(const int16_t *restrict r1, const int16_t *restrict r2, 
+	       int16_t *restrict l1, int16_t *restrict l2, int half, int k, 
+	       int t, const int mode){
+
+	int16_t d0=0, d1=0, s0=0, s1=0;
+
+	for(; k<half; k++){
+		d0 = r1[2*k] - r1[2*k+1];
+		s0 = r1[2*k+1] + (d0 >> 1);
+		d1 = r2[2*k] - r2[2*k+1];
+		s1 = r2[2*k+1] + (d1 >> 1);
+		l1[k] = s1 + ((s0 - s1) >> 1);
+		l1[half+k] = shrink(d1 + ((d0 - d1) >> 1), t, mode);
+		l2[k] = shrink(s0 - s1, t, mode);
+		l2[half+k] = shrink(d0 - d1, t, mode);
+	}/*eo for*/
+
+}/*eo lift_span*/
+
+static void lift_quad_scalar(const int16_t *restrict r1, 
+			     const int16_t *restrict r2, 
+			     int16_t *restrict l1, int16_t *restrict l2, 
+			     int width, int t, int mode){
+
+	if(mode == SHRINK_SOFT)
+		lift_span(r1, r2, l1, l2, width/2, 0, t, SHRINK_SOFT);
+	else if(mode == SHRINK_HARD)
+		lift_span(r1, r2, l1, l2, width/2, 0, t, SHRINK_HARD);
+	else
+		lift_span(r1, r2, l1, l2, width/2, 0, 0, SHRINK_NONE);
+
+}/*eo lift_quad_scalar*/
+
+/*
+** unlift_quad
+** inverse of lift_quad, down the columns and then along the rows, 
+** b = s - (d >> 1), a = d + b, the rows go to l1 and l2. unlift_span 
+** does the windows from k on, the simd kernels use it for their tails.
+*/
+static inline void unlift_span(const int16_t *restrict r1, 
+			       const int16_t *restrict r2, 
+			       int16_t *restrict l1, int16_t *restrict l2,
+			       int half, int k){
+
+	int16_t d0=0, d1=0, s0=0, s1=0;
+
+	for(; k<half; k++){
+		s1 = r1[k] - (r2[k] >> 1);
+		s0 = r2[k] + s1;
+		d1 = r1[half+k] - (r2[half+k] >> 1);
+		d0 = r2[half+k] + d1;
+		l1[2*k+1] = s0 - (d0 >> 1);
+		l1[2*k] = d0 + l1[2*k+1];
+		l2[2*k+1] = s1 - (d1 >> 1);
+		l2[2*k] = d1 + l2[2*k+1];
+	}/*eo for*/
+
+}/*eo unlift_span*/
+
+static void unlift_quad_scalar(const int16_t *restrict r1, 
+			       const int16_t *restrict r2,
+			       int16_t *restrict l1, int16_t *restrict l2,
+			       int width){
+
+	unlift_span(r1, r2, l1, l2, width/2, 0);
+
+}/*eo unlift_quad_scalar*/
+
+/*
+** simd unlift_quad
+** the scalar steps wrap in 16 bits like the int16_t stores, so they map
+** onto 16 bit lanes one to one: >> 1 is an arithmetic shift and the 
+** even (a) and odd (b) outputs are interleaved on the store. the result
+** is identical to unlift_quad_scalar() for any coefficients.
+*/
+void (*unlift_quad_simd)(const int16_t *restrict r1, 
+			 const int16_t *restrict r2,
+			 int16_t *restrict l1, int16_t *restrict l2, 
+			 int width) = unlift_quad_scalar;
+
+/*
+** simd lift_quad
+** the smooth values s1 + ((s0 - s1) >> 1) are taken before the 16 bit
+** wrap, that is the floor of the mean, which the lanes get without 
+** overflow as (a & b) + ((a ^ b) >> 1) (vhadd on neon). the other steps
+** wrap like the int16_t stores. soft shrinkage is v - clamp(v, -t, t),
+** hard keeps v where v > t or v < -t. t is 0..32767. the result is 
+** identical to lift_quad_scalar() for any coefficients.
+*/
+void (*lift_quad_simd)(const int16_t *restrict r1, 
+		       const int16_t *restrict r2, 
+		       int16_t *restrict l1, int16_t *restrict l2, int width,
+		       int t, int mode) = lift_quad_scalar;
+
+#if defined(__x86_64__) || defined(__i386__)
+
+static inline void haar_deinterleave_sse2(const uint16_t *p, __m128i *c1, 
+					  __m128i *c2);
+
+static inline __m128i lift_mean_sse2(__m128i a, __m128i b){
+
+	return(_mm_add_epi16(_mm_and_si128(a, b), 
+			     _mm_srai_epi16(_mm_xor_si128(a, b), 1)));
+
+}/*eo lift_mean_sse2*/
+
+static inline __attribute__((always_inline)) 
+__m128i shrink_sse2(__m128i v, __m128i t, __m128i nt, const int mode){
+
+	if(mode == SHRINK_HARD)
+		return(_mm_and_si128(v, _mm_or_si128(_mm_cmpgt_epi16(v, t), 
+						     _mm_cmplt_epi16(v, nt))));
+	if(mode == SHRINK_SOFT)
+		return(_mm_sub_epi16(v, _mm_max_epi16(_mm_min_epi16(v, t), nt)));
+
+	return(v);
+
+}/*eo shrink_sse2*/
+
+/*
+** eight windows per iteration
+*/
+static inline __attribute__((always_inline)) 
+void lift_span_sse2(const int16_t *restrict r1, 
+		    const int16_t *restrict r2, 
+		    int16_t *restrict l1, int16_t *restrict l2, int width, 
+		    int t, const int mode){
+
+	const int half = width/2;
+	const __m128i vt = _mm_set1_epi16(t), nt = _mm_set1_epi16(-t);
+	__m128i a, b, c, e, s0, s1, d0, d1;
+	int k=0;
+
+	for(k=0; k+8<=half; k+=8){
+		haar_deinterleave_sse2((const uint16_t *)r1 + 2*k, &a, &b);
+		haar_deinterleave_sse2((const uint16_t *)r2 + 2*k, &c, &e);
+
+		d0 = _mm_sub_epi16(a, b);
+		s0 = _mm_add_epi16(b, _mm_srai_epi16(d0, 1));
+		d1 = _mm_sub_epi16(c, e);
+		s1 = _mm_add_epi16(e, _mm_srai_epi16(d1, 1));
+
+		_mm_storeu_si128((__m128i *)(l1 + k), lift_mean_sse2(s0, s1));
+		_mm_storeu_si128((__m128i *)(l1 + half + k), 
+				 shrink_sse2(lift_mean_sse2(d0, d1), vt, nt, mode));
+		_mm_storeu_si128((__m128i *)(l2 + k), 
+				 shrink_sse2(_mm_sub_epi16(s0, s1), vt, nt, mode));
+		_mm_storeu_si128((__m128i *)(l2 + half + k), 
+				 shrink_sse2(_mm_sub_epi16(d0, d1), vt, nt, mode));
+	}/*eo for*/
+	lift_span(r1, r2, l1, l2, half, k, t, mode);
+
+}/*eo lift_span_sse2*/
+
+static void lift_quad_sse2(const int16_t *restrict r1, 
+			   const int16_t *restrict r2, 
+			   int16_t *restrict l1, int16_t *restrict l2, 
+			   int width, int t, int mode){
+
+	if(mode == SHRINK_SOFT)
+		lift_span_sse2(r1, r2, l1, l2, width, t, SHRINK_SOFT);
+	else if(mode == SHRINK_HARD)
+		lift_span_sse2(r1, r2, l1, l2, width, t, SHRINK_HARD);
+	else
+		lift_span_sse2(r1, r2, l1, l2, width, 0, SHRINK_NONE);
+
+}/*eo lift_quad_sse2*/
+
+/*
+** eight windows per iteration
+*/
+static void unlift_quad_sse2(const int16_t *restrict r1, 
+			     const int16_t *restrict r2,
+			     int16_t *restrict l1, int16_t *restrict l2,
+			     int width){
+
+	const int half = width/2;
+	__m128i ll, lh, hl, hh, s0, s1, d0, d1, a, b;
+	int k=0;
+
+	for(k=0; k+8<=half; k+=8){
+		ll = _mm_loadu_si128((__m128i *)(r1 + k));
+		lh = _mm_loadu_si128((__m128i *)(r2 + k));
+		hl = _mm_loadu_si128((__m128i *)(r1 + half + k));
+		hh = _mm_loadu_si128((__m128i *)(r2 + half + k));
+
+		s1 = _mm_sub_epi16(ll, _mm_srai_epi16(lh, 1));
+		s0 = _mm_add_epi16(lh, s1);
+		d1 = _mm_sub_epi16(hl, _mm_srai_epi16(hh, 1));
+		d0 = _mm_add_epi16(hh, d1);
+
+		b = _mm_sub_epi16(s0, _mm_srai_epi16(d0, 1));
+		a = _mm_add_epi16(d0, b);
+		_mm_storeu_si128((__m128i *)(l1 + 2*k), _mm_unpacklo_epi16(a, b));
+		_mm_storeu_si128((__m128i *)(l1 + 2*k + 8), 
+				 _mm_unpackhi_epi16(a, b));
+		b = _mm_sub_epi16(s1, _mm_srai_epi16(d1, 1));
+		a = _mm_add_epi16(d1, b);
+		_mm_storeu_si128((__m128i *)(l2 + 2*k), _mm_unpacklo_epi16(a, b));
+		_mm_storeu_si128((__m128i *)(l2 + 2*k + 8), 
+				 _mm_unpackhi_epi16(a, b));
+	}/*eo for*/
+	unlift_span(r1, r2, l1, l2, half, k);
+
+}/*eo unlift_quad_sse2*/
+
+#endif /*x86*/
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+static inline __attribute__((always_inline)) 
+int16x8_t shrink_neon(int16x8_t v, int16x8_t t, int16x8_t nt, 
+		      const int mode){
+
+	if(mode == SHRINK_HARD)
+		return(vandq_s16(v, vreinterpretq_s16_u16(
+			vorrq_u16(vcgtq_s16(v, t), vcltq_s16(v, nt)))));
+	if(mode == SHRINK_SOFT)
+		return(vsubq_s16(v, vmaxq_s16(vminq_s16(v, t), nt)));
+
+	return(v);
+
+}/*eo shrink_neon*/
+
+/*
+** eight windows per iteration, vld2 splits the even and odd columns
+*/
+static inline __attribute__((always_inline)) 
+void lift_span_neon(const int16_t *restrict r1, 
+		    const int16_t *restrict r2, 
+		    int16_t *restrict l1, int16_t *restrict l2, int width, 
+		    int t, const int mode){
+
+	const int half = width/2;
+	const int16x8_t vt = vdupq_n_s16(t), nt = vdupq_n_s16(-t);
+	int16x8x2_t p1, p2;
+	int16x8_t s0, s1, d0, d1;
+	int k=0;
+
+	for(k=0; k+8<=half; k+=8){
+		p1 = vld2q_s16(r1 + 2*k);
+		p2 = vld2q_s16(r2 + 2*k);
+
+		d0 = vsubq_s16(p1.val[0], p1.val[1]);
+		s0 = vaddq_s16(p1.val[1], vshrq_n_s16(d0, 1));
+		d1 = vsubq_s16(p2.val[0], p2.val[1]);
+		s1 = vaddq_s16(p2.val[1], vshrq_n_s16(d1, 1));
+
+		vst1q_s16(l1 + k, vhaddq_s16(s0, s1));
+		vst1q_s16(l1 + half + k, 
+			  shrink_neon(vhaddq_s16(d0, d1), vt, nt, mode));
+		vst1q_s16(l2 + k, shrink_neon(vsubq_s16(s0, s1), vt, nt, mode));
+		vst1q_s16(l2 + half + k, 
+			  shrink_neon(vsubq_s16(d0, d1), vt, nt, mode));
+	}/*eo for*/
+	lift_span(r1, r2, l1, l2, half, k, t, mode);
+
+}/*eo lift_span_neon*/
+
+static void lift_quad_neon(const int16_t *restrict r1, 
+			   const int16_t *restrict r2, 
+			   int16_t *restrict l1, int16_t *restrict l2, 
+			   int width, int t, int mode){
+
+	if(mode == SHRINK_SOFT)
+		lift_span_neon(r1, r2, l1, l2, width, t, SHRINK_SOFT);
+	else if(mode == SHRINK_HARD)
+		lift_span_neon(r1, r2, l1, l2, width, t, SHRINK_HARD);
+	else
+		lift_span_neon(r1, r2, l1, l2, width, 0, SHRINK_NONE);
+
+}/*eo lift_quad_neon*/
+
+/*
+** eight windows per iteration, vst2 interleaves the even and odd 
+** columns
+*/
+static void unlift_quad_neon(const int16_t *restrict r1, 
+			     const int16_t *restrict r2,
+			     int16_t *restrict l1, int16_t *restrict l2,
+			     int width){
+
+	const int half = width/2;
+	int16x8_t ll, lh, hl, hh, s0, s1, d0, d1;
+	int16x8x2_t ab;
+	int k=0;
+
+	for(k=0; k+8<=half; k+=8){
+		ll = vld1q_s16(r1 + k);
+		lh = vld1q_s16(r2 + k);
+		hl = vld1q_s16(r1 + half + k);
+		hh = vld1q_s16(r2 + half + k);
+
+		s1 = vsubq_s16(ll, vshrq_n_s16(lh, 1));
+		s0 = vaddq_s16(lh, s1);
+		d1 = vsubq_s16(hl, vshrq_n_s16(hh, 1));
+		d0 = vaddq_s16(hh, d1);
+
+		ab.val[1] = vsubq_s16(s0, vshrq_n_s16(d0, 1));
+		ab.val[0] = vaddq_s16(d0, ab.val[1]);
+		vst2q_s16(l1 + 2*k, ab);
+		ab.val[1] = vsubq_s16(s1, vshrq_n_s16(d1, 1));
+		ab.val[0] = vaddq_s16(d1, ab.val[1]);
+		vst2q_s16(l2 + 2*k, ab);
+	}/*eo for*/
+	unlift_span(r1, r2, l1, l2, half, k);
+
+}/*eo unlift_quad_neon*/
+
+#endif /*neon*/
+
+/*
+** lift_permute_rows
+** move the even rows (smooth) of a height row block to the top half and
+** the odd rows (detail) to the bottom half in place, or back again with
+** inverse set. the permutation is followed cycle by cycle from its 
+** smallest row with one line buffer.
+*/
+static inline int lift_row_src(int cur, int half, int inverse){
+
+	if(inverse)
+		return(cur & 1 ? half + cur/2 : cur/2);
+
+	return(cur < half ? 2*cur : 2*(cur-half) + 1);
+
+}/*eo lift_row_src*/
+
+static void lift_permute_rows(int16_t *p, int width, int height, 
+			      int stride, int16_t *line, int inverse){
+
+	const int half = height/2;
+	int start=0, cur=0, src=0;
+
+	for(start=1; start<height-1; start++){
+
+		/*
+		** the row that ends up at cur comes from src
+		*/
+		cur = start;
+		do{
+			cur = lift_row_src(cur, half, inverse);
+		}while(cur > start);
+		if(cur < start)
+			continue;	/*cycle already moved*/
+
+		memcpy(line, p + start*stride, width*sizeof(int16_t));
+		cur = start;
+		for(;;){
+			src = lift_row_src(cur, half, inverse);
+			if(src == start) break;
+			memcpy(p + cur*stride, p + src*stride, 
+			       width*sizeof(int16_t));
+			cur = src;
+		}/*eo for*/
+		memcpy(p + cur*stride, line, width*sizeof(int16_t));
+
+	}/*eo for*/
+
+}/*eo lift_permute_rows*/
+
+/*
+** lift_rows / unlift_rows
+** one level on the row pairs first .. last-1 of a width wide block, line
+** holds two rows. thresh >= 0 shrinks the details soft or hard.
+*/
+static void lift_rows(int16_t *plane, int width, int stride, int first, 
+		      int last, int16_t *line, int thresh, int soft){
+
+	int16_t *r1=NULL;
+	int y=0;
+
+	for(y=first; y<last; y++){
+		r1 = plane + 2*y*stride;
+		lift_quad_simd(r1, r1 + stride, line, line + width, width, 
+			       thresh, thresh < 0 ? SHRINK_NONE : 
+			       soft ? SHRINK_SOFT : SHRINK_HARD);
+		memcpy(r1, line, width*sizeof(int16_t));
+		memcpy(r1 + stride, line + width, width*sizeof(int16_t));
+	}/*eo for*/
+
+}/*eo lift_rows*/
+
+static void unlift_rows(int16_t *plane, int width, int stride, int first, 
+			int last, int16_t *line){
+
+	int16_t *r1=NULL;
+	int y=0;
+
+	for(y=first; y<last; y++){
+		r1 = plane + 2*y*stride;
+		unlift_quad_simd(r1, r1 + stride, line, line + width, width);
+		memcpy(r1, line, width*sizeof(int16_t));
+		memcpy(r1 + stride, line + width, width*sizeof(int16_t));
+	}/*eo for*/
+
+}/*eo unlift_rows*/
+
+/*
+** HaarLift
+** levels of the forward S-transform on a width x height int16 plane with
+** a line length of stride elements. returns the number of levels done.
+*/
+int HaarLift(int16_t *plane, int width, int height, int stride, int levels){
+
+	int16_t line[2*MAX_FRAME_WIDTH];
+	int n=0, l=0, w=width, h=height;
+
+	if(width > MAX_FRAME_WIDTH || height > MAX_FRAME_WIDTH)
+		return(-1);
+	n = lift_levels(width, height, levels);
+
+	for(l=0; l<n; l++, w/=2, h/=2){
+		lift_rows(plane, w, stride, 0, h/2, line, -1, 0);
+		lift_permute_rows(plane, w, h, stride, line, 0);
+	}/*eo for*/
+
+	return(n);
+
+}/*eo HaarLift*/
+
+/*
+** HaarUnlift
+** inverse of HaarLift with the same levels, rebuilds the plane exactly.
+** returns the number of levels undone.
+*/
+int HaarUnlift(int16_t *plane, int width, int height, int stride, 
+	       int levels){
+
+	int16_t line[2*MAX_FRAME_WIDTH];
+	int n=0, l=0, w=0, h=0;
+
+	if(width > MAX_FRAME_WIDTH || height > MAX_FRAME_WIDTH)
+		return(-1);
+	n = lift_levels(width, height, levels);
+
+	for(l=n-1; l>=0; l--){
+		w = width >> l;
+		h = height >> l;
+		lift_permute_rows(plane, w, h, stride, line, 1);
+		unlift_rows(plane, w, stride, 0, h/2, line);
+	}/*eo for*/
+
+	return(n);
+
+}/*eo HaarUnlift*/
+
+/*
+** Rgb565ToPlanes
+** unpack a width x height rgb565 frame into three int16 planes of
+** width x height, in the order the pixel holds the channels from the 
+** top bits down (5, 6 and 5 bits)
+*/
+static inline void rgb565_unpack(const uint16_t *restrict in, 
+				 int16_t *restrict p0, int16_t *restrict p1,
+				 int16_t *restrict p2, int npixels){
+
+	int i=0;
+
+	for(i=0; i<npixels; i++){
+		p0[i] = in[i] >> 11;
+		p1[i] = (in[i] >> 5) & 0x3f;
+		p2[i] = in[i] & 0x1f;
+	}/*eo for*/
+
+}/*eo rgb565_unpack*/
+
+int Rgb565ToPlanes(uint16_t *rgb565ptr, int16_t *planes, int width, 
+		   int height){
+
+	const int n = width*height;
+
+	rgb565_unpack(rgb565ptr, planes, planes + n, planes + 2*n, n);
+
+	return(0);
+
+}/*eo Rgb565ToPlanes*/
+
+/*
+** PlanesToRgb565
+** pack three int16 planes back into a rgb565 frame, the inverse of
+** Rgb565ToPlanes. values outside a channel are clamped so that edited
+** coefficients still give a valid frame.
+*/
+static inline uint16_t plane_clamp(int v, int max){
+
+	return(v < 0 ? 0 : v > max ? max : v);
+
+}/*eo plane_clamp*/
+
+static inline void rgb565_pack(const int16_t *restrict p0, 
+			       const int16_t *restrict p1, 
+			       const int16_t *restrict p2, 
+			       uint16_t *restrict out, int npixels){
+
+	int i=0;
+
+	for(i=0; i<npixels; i++)
+		out[i] = (plane_clamp(p0[i], 0x1f) << 11) | 
+			 (plane_clamp(p1[i], 0x3f) << 5) | 
+			 plane_clamp(p2[i], 0x1f);
+
+}/*eo rgb565_pack*/
+
+int PlanesToRgb565(int16_t *planes, uint16_t *rgb565ptr, int width, 
+		   int height){
+
+	const int n = width*height;
+
+	rgb565_pack(planes, planes + n, planes + 2*n, rgb565ptr, n);
+
+	return(0);
+
+}/*eo PlanesToRgb565*/
+
+
+
+
+
+/*
+** capture_map_buffers
+** query and memory map every buffer granted by VIDIOC_REQBUFS
+*/
+int capture_map_buffers(int fd, int nbufs){
+
+	struct v4l2_buffer buf;
+	int i=0;
+
+	for(i=0; i<nbufs; i++){
+
+		/*
+		** query the offset and length of the buffer
+		*/
+		memset(&buf, 0, sizeof(buf));
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index = i;
+
+		if(ioctl(fd, VIDIOC_QUERYBUF, &buf) < 0)
+		{
+			perror("VIDIOC_QUERYBUF");
+			return(-1);
+		}/*eo if*/
+
+		/*
+		** map webcam buffer to user space
+		*/
+		cap_buf[i] = mmap(NULL, buf.length, PROT_READ | PROT_WRITE,
+				  MAP_SHARED, fd, buf.m.offset);
+		if(cap_buf[i] == MAP_FAILED)
+		{
+			printf("camera - mmap buffer %d failed errno=%d\n", i, errno);
+			cap_buf[i] = NULL;
+			return(-1);
+		}/*eo if*/
+		cap_len[i] = buf.length;
+
+	}/*eo for*/
+
+	return(0);
+
+}/*eo capture_map_buffers*/
+
+/*
+** capture_queue
+** give buffer index back to the driver to be filled
+*/
+int capture_queue(int fd, int index){
+
+	struct v4l2_buffer buf;
+
+	memset(&buf, 0, sizeof(buf));
+	buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	buf.memory = V4L2_MEMORY_MMAP;
+	buf.index = index;
+
+	if(ioctl(fd, VIDIOC_QBUF, &buf) < 0)
+	{
+		perror("VIDIOC_QBUF");
+		return(-1);
+	}/*eo if*/
+	if(atomic_fetch_add(&cap_queued, 1) == 0)
+		futex_wake(&cap_queued);
+
+	return(0);
+
+}/*eo capture_queue*/
+
+/*
+** capture_wait_queued
+** sleep until a buffer is queued to be filled, in the pipeline the 
+** process stage may hold all of them. returns -1 once the pipeline is
+** stopping.
+*/
+static int capture_wait_queued(void){
+
+	while(atomic_load(&cap_queued) == 0){
+		if(atomic_load(&pipe_stop))
+			return(-1);
+		futex_wait(&cap_queued, 0, PIPE_WAIT_MS);
+	}/*eo while*/
+
+	return(0);
+
+}/*eo capture_wait_queued*/
+
+/*
+** capture_unmap_buffers
+** release the capture buffer ring
+*/
+void capture_unmap_buffers(int nbufs){
+
+	int i=0;
+
+	for(i=0; i<nbufs; i++){
+		if(cap_buf[i]) munmap(cap_buf[i], cap_len[i]);
+		cap_buf[i] = NULL;
+	}/*eo for*/
+
+}/*eo capture_unmap_buffers*/
+
+/*
+** capture_dequeue_latest
+** wait with poll() until the camera has filled at least one buffer, then
+** drain every ready buffer. Older buffers are requeued immediately and
+** counted as dropped, the newest one is returned in latest.
+** the webcam must have been opened with O_NONBLOCK.
+*/
+int capture_dequeue_latest(int fd, struct v4l2_buffer *latest){
+
+	struct pollfd pfd;
+	struct v4l2_buffer buf;
+	int have=0, result=0;
+
+	while(!have){
+
+		/*
+		** wait for a filled buffer
+		*/
+		pfd.fd = fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		result = poll(&pfd, 1, CAPTURE_TIMEOUT_MS);
+		if(result < 0){
+			if(errno == EINTR) continue;
+			perror("poll");
+			return(-1);
+		}/*eo if*/
+		if(result == 0){
+			fprintf(stderr, "capture timeout\n");
+			return(-1);
+		}/*eo if*/
+
+		/*
+		** drain every ready buffer
+		*/
+		for(;;){
+			memset(&buf, 0, sizeof(buf));
+			buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+			buf.memory = V4L2_MEMORY_MMAP;
+			if(ioctl(fd, VIDIOC_DQBUF, &buf) < 0){
+				if(errno == EAGAIN) break;
+				if(errno == EINTR) continue;
+				perror("VIDIOC_DQBUF");
+				return(-1);
+			}/*eo if*/
+			cap_queued--;
+
+			/*
+			** a newer frame is ready, the previous one is stale
+			*/
+			if(have){
+				if(capture_queue(fd, latest->index) < 0)
+					return(-1);
+				frames_dropped++;
+			}/*eo if*/
+			*latest = buf;
+			have = 1;
+		}/*eo for*/
+
+	}/*eo while*/
+
+	return(0);
+
+}/*eo capture_dequeue_latest*/
+
+/*
+** capture_next
+** get the next filled buffer from the camera using either a blocking
+** VIDIOC_DQBUF or the latest frame wins drain, and record how many
+** buffers are still in flight
+*/
+int capture_next(struct v4l2_buffer *buf){
+
+	int inflight=0;
+
+	if(source->next(buf) < 0)
+		return(-1);
+
+	/*
+	** the remaining queued buffers keep the camera busy while
+	** this frame is processed
+	*/
+	inflight = cap_queued;
+	inflight_hist[inflight]++;
+	inflight_sum += inflight;
+	inflight_samples++;
+	if(inflight < inflight_min) inflight_min = inflight;
+	if(inflight > inflight_max) inflight_max = inflight;
+	if(verbose) printf("buffer %d: %d in flight\n", buf->index, inflight);
+
+	return(0);
+
+}/*eo capture_next*/
+
+/*
+** capture_release
+** give a processed buffer back to the capture source
+*/
+int capture_release(int index){
+
+	return(source->release(index));
+
+}/*eo capture_release*/
+
+/*
+** capture sources
+*/
+static int v4l2_open(char *arg);
+static int v4l2_start(void);
+static int v4l2_next(struct v4l2_buffer *buf);
+static int v4l2_release(int index);
+static void v4l2_close(void);
+static int file_open(char *arg);
+static int synth_open(char *arg);
+static int mem_start(void);
+static int mem_next(struct v4l2_buffer *buf);
+static int mem_release(int index);
+static void mem_close(void);
+
+static struct capture_source sources[] = {
+	{ "v4l2", v4l2_open, v4l2_start, v4l2_next, v4l2_release, v4l2_close },
+	{ "file", file_open, mem_start, mem_next, mem_release, mem_close },
+	{ "synth", synth_open, mem_start, mem_next, mem_release, mem_close },
+};
+
+/*
+** capture_open
+** open the source named by spec, name[:argument]
+*/
+int capture_open(char *spec){
+
+	char name[16];
+	char *arg = strchr(spec, ':');
+	int i=0, n = arg ? arg - spec : (int)strlen(spec);
+
+	snprintf(name, sizeof(name), "%.*s", n, spec);
+	for(i=0; i<(int)(sizeof(sources)/sizeof(sources[0])); i++){
+		if(strcmp(name, sources[i].name) == 0){
+			source = &sources[i];
+			return(source->open(arg ? arg+1 : NULL));
+		}/*eo if*/
+	}/*eo for*/
+
+	fprintf(stderr, "unknown capture source %s\n", spec);
+	return(-1);
+
+}/*eo capture_open*/
+
+/*
+** v4l2 source
+** the webcam, by default /dev/video0
+*/
+static int v4l2_open(char *arg){
+
+	char *device = arg ? arg : "/dev/video0";
+	int i=0;
+
+	/*
+	** open webcam
+	** video0 = Logitech C920 USB Webcam on Beagle Bone Black
+	*/
+	if((vid_fd = open(device, O_RDWR | (latest ? O_NONBLOCK : 0))) < 0)
+	{
+		perror("webcam open");
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** get webcam capabilites	
+	*/
+	if(ioctl(vid_fd, VIDIOC_QUERYCAP, &v4l2_cap) < 0)
+	{
+		perror("VIDIOC_QUERYCAP");
+		return(-1);
+	}/*eo if*/
+
+	
+	if(!(v4l2_cap.capabilities & V4L2_CAP_VIDEO_CAPTURE))
+	{
+		fprintf(stderr, "The device does not handle single-planar video\n");
+		return(-1);
+	}//eo if
+
+	
+	if(!(v4l2_cap.capabilities & V4L2_CAP_STREAMING))
+	{
+		fprintf(stderr, "The device does not handle frame streaming\n");
+		return(-1);
+	}//eo if
+
+	/*
+	** set the webcam format
+	*/
+	memset(&v4l2_fmt, 0, sizeof(v4l2_fmt));
+	v4l2_fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	v4l2_fmt.fmt.pix.pixelformat = V4L2_PIX_FMT_YUYV;
+	v4l2_fmt.fmt.pix.width =  cap_geo.width;	/*432*/	
+	v4l2_fmt.fmt.pix.height = cap_geo.height;	/*240*/
+
+	if(ioctl(vid_fd, VIDIOC_S_FMT, &v4l2_fmt) <0)
+	{
+		perror("VIDIOC_S_FMT");
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** the driver adjusts the size to the nearest one it supports, read
+	** back the format it actually streams
+	*/
+	if(ioctl(vid_fd, VIDIOC_G_FMT, &v4l2_fmt) <0)
+	{
+		perror("VIDIOC_G_FMT");
+		return(-1);
+	}/*eo if*/
+	cap_geo.width = v4l2_fmt.fmt.pix.width;
+	cap_geo.height = v4l2_fmt.fmt.pix.height;
+	cap_geo.stride = v4l2_fmt.fmt.pix.bytesperline;
+	cap_geo.pixfmt = v4l2_fmt.fmt.pix.pixelformat;
+	if(cap_geo.stride < cap_geo.width*2)
+		cap_geo.stride = cap_geo.width*2;
+	if(cap_geo.pixfmt != V4L2_PIX_FMT_YUYV || cap_geo.width%2 || 
+	   cap_geo.height%2 || cap_geo.width > MAX_FRAME_WIDTH)
+	{
+		fprintf(stderr, "unsupported webcam format %dx%d %.4s\n", 
+			cap_geo.width, cap_geo.height, (char *)&cap_geo.pixfmt);
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** request buffer(s)
+	** initiate memory mapped I/O. Memory mapped buffers are located in device
+	** memory and must be allocated before they can be mapped into the applications
+	** I/O space. The driver may grant fewer buffers than requested.
+	*/
+	memset(&v4l2_reqbuf, 0, sizeof(v4l2_reqbuf));
+	v4l2_reqbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	v4l2_reqbuf.memory = V4L2_MEMORY_MMAP;
+	v4l2_reqbuf.count = nbufs;
+	
+	if(ioctl(vid_fd, VIDIOC_REQBUFS, &v4l2_reqbuf) < 0)
+	{
+		perror("VIDIOC_REQBUFS");
+		return(-1);
+	}/*eo if*/
+
+	if(v4l2_reqbuf.count < 1 || v4l2_reqbuf.count > MAX_CAPBUFS)
+	{
+		fprintf(stderr, "VIDIOC_REQBUFS granted %d buffers\n", 
+			v4l2_reqbuf.count);
+		return(-1);
+	}/*eo if*/
+	nbufs = v4l2_reqbuf.count;
+
+	/*
+	** map every webcam buffer into user space
+	*/
+	if(capture_map_buffers(vid_fd, nbufs) < 0)
+		return(-1);
+
+	/*
+	** hand the whole ring to the driver before streaming starts so the
+	** camera always has a buffer to fill
+	*/
+	for(i=0; i<nbufs; i++){
+		if(capture_queue(vid_fd, i) < 0)
+			return(-1);
+	}/*eo for*/
+
+	return(0);
+
+}/*eo v4l2_open*/
+
+static int v4l2_start(void){
+
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+	if(ioctl(vid_fd, VIDIOC_STREAMON, &type) < 0)
+	{
+		perror("VIDIOC_STREAMON");
+		return(-1);
+	}/*eo if*/
+
+	return(0);
+
+}/*eo v4l2_start*/
+
+static int v4l2_next(struct v4l2_buffer *buf){
+
+	struct pollfd pfd;
+	int result=0;
+
+	if(capture_wait_queued() < 0)
+		return(-1);
+
+	if(latest){
+
+		/*
+		** wait for the camera, then keep only the newest
+		** filled buffer
+		*/
+		if(capture_dequeue_latest(vid_fd, buf) < 0)
+			return(-1);
+
+	}else{
+
+		/*
+		** sleep in poll() until the oldest queued buffer is filled
+		*/
+		pfd.fd = vid_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		while((result = poll(&pfd, 1, CAPTURE_TIMEOUT_MS)) < 0 && 
+		      errno == EINTR)
+			;
+		if(result < 0){
+			perror("poll");
+			return(-1);
+		}/*eo if*/
+		if(result == 0){
+			fprintf(stderr, "capture timeout\n");
+			return(-1);
+		}/*eo if*/
+
+		/* 
+		** the oldest queued buffer has been filled by the video 
+		** camera get the buffer for futher processing 
+		*/	
+		memset(buf, 0, sizeof(*buf));
+		buf->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf->memory = V4L2_MEMORY_MMAP;
+		if(ioctl(vid_fd, VIDIOC_DQBUF, buf) < 0)
+		{
+			perror("VIDIOC_DQBUF");
+			printf("ERRNO %d\n", errno);
+			return(-1);
+		}/*eo if*/
+		cap_queued--;
+
+	}/*eo if*/
+
+	return(0);
+
+}/*eo v4l2_next*/
+
+static int v4l2_release(int index){
+
+	return(capture_queue(vid_fd, index));
+
+}/*eo v4l2_release*/
+
+static void v4l2_close(void){
+
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+	if(ioctl(vid_fd, VIDIOC_STREAMOFF, &type) < 0)
+		perror("VIDIOC_STREAMOFF");
+	capture_unmap_buffers(nbufs);
+	close(vid_fd);
+
+}/*eo v4l2_close*/
+
+/*
+** memory sources
+** the file and synth sources hand out frames of a buffer in memory
+** (mem_frames, mem_nframes frames of mem_frame_size bytes) in a loop.
+** the capture buffers are slots pointing into it, mem_free[] marks the
+** slots that have been released. with source_fps the frames are paced
+** and stamped with their due time, a frame that is late is delivered
+** at once, or skipped and counted as dropped in latest frame mode.
+*/
+uint8_t *mem_frames = NULL;
+size_t mem_size = 0;
+int mem_nframes = 0, mem_mapped = 0;
+long mem_frame_size = 0, mem_seq = 0;
+int mem_slot = 0;
+_Atomic int mem_free[MAX_CAPBUFS];
+struct timespec mem_t0;
+
+/*
+** every slot starts out released, like a fully queued v4l2 ring
+*/
+static int mem_init(uint8_t *frames, int nframes){
+
+	int i=0;
+
+	mem_frames = frames;
+	mem_nframes = nframes;
+	for(i=0; i<nbufs; i++){
+		cap_buf[i] = frames;
+		cap_len[i] = mem_frame_size;
+		atomic_store(&mem_free[i], 1);
+	}/*eo for*/
+	cap_queued = nbufs;
+
+	return(0);
+
+}/*eo mem_init*/
+
+/*
+** file source
+** memory map a recording of raw frames of the -s size
+*/
+static int file_open(char *arg){
+
+	struct stat st;
+	int fd=0;
+	void *p=NULL;
+
+	if(arg == NULL){
+		fprintf(stderr, "file source needs a path, -S file:path\n");
+		return(-1);
+	}/*eo if*/
+	if((fd = open(arg, O_RDONLY)) < 0 || fstat(fd, &st) < 0){
+		perror("capture file");
+		return(-1);
+	}/*eo if*/
+
+	cap_geo.stride = cap_geo.width*2;
+	mem_frame_size = (long)cap_geo.stride*cap_geo.height;
+	if(st.st_size < mem_frame_size){
+		fprintf(stderr, "%s holds no %dx%d frame\n", arg, cap_geo.width,
+			cap_geo.height);
+		close(fd);
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** populate the mapping so replay does not page fault
+	*/
+	mem_size = st.st_size - st.st_size%mem_frame_size;
+	p = mmap(NULL, mem_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+	close(fd);
+	if(p == MAP_FAILED){
+		printf("capture file - mmap failed errno %d\n", errno);
+		return(-1);
+	}/*eo if*/
+	mem_mapped = 1;
+
+	return(mem_init(p, mem_size/mem_frame_size));
+
+}/*eo file_open*/
+
+/*
+** synth source
+** SYNTH_FRAMES frames of colour bars over a luma ramp that moves by a
+** few pixels per frame, in the byte order of the c920 (Y1 V0 Y0 U0)
+*/
+static int synth_open(char *arg){
+
+	static const uint8_t bar_u[8] = { 128, 16, 166, 54, 202, 90, 240, 128 };
+	static const uint8_t bar_v[8] = { 128, 146, 16, 34, 222, 240, 110, 128 };
+	uint8_t *frames=NULL, *p=NULL;
+	int n=0, x=0, y=0, bar=0;
+
+	(void)arg;
+
+	cap_geo.stride = cap_geo.width*2;
+	mem_frame_size = (long)cap_geo.stride*cap_geo.height;
+	mem_size = mem_frame_size*SYNTH_FRAMES;
+	if((frames = malloc(mem_size)) == NULL){
+		printf("synth - malloc failed\n");
+		return(-1);
+	}/*eo if*/
+
+	for(n=0; n<SYNTH_FRAMES; n++){
+		for(y=0; y<cap_geo.height; y++){
+			p = frames + n*mem_frame_size + y*cap_geo.stride;
+			for(x=0; x<cap_geo.width; x+=2){
+				bar = x*8/cap_geo.width;
+				p[0] = 16 + (x + 1 + y + 4*n)%220;	/*Y1*/
+				p[1] = bar_v[bar];			/*V0*/
+				p[2] = 16 + (x + y + 4*n)%220;		/*Y0*/
+				p[3] = bar_u[bar];			/*U0*/
+				p += 4;
+			}/*eo for*/
+		}/*eo for*/
+	}/*eo for*/
+	mem_mapped = 0;
+
+	return(mem_init(frames, SYNTH_FRAMES));
+
+}/*eo synth_open*/
+
+static int mem_start(void){
+
+	clock_gettime(CLOCK_MONOTONIC, &mem_t0);
+	mem_seq = 0;
+
+	return(0);
+
+}/*eo mem_start*/
+
+static int mem_next(struct v4l2_buffer *buf){
+
+	struct timespec due;
+	int64_t t0=0, now=0, t_due=0, late=0;
+
+	/*
+	** wait for a released slot, like VIDIOC_DQBUF on an empty ring
+	*/
+	if(capture_wait_queued() < 0)
+		return(-1);
+	while(!atomic_load(&mem_free[mem_slot]))
+		mem_slot = (mem_slot + 1)%nbufs;
+
+	memset(buf, 0, sizeof(*buf));
+	buf->flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+	clock_gettime(CLOCK_MONOTONIC, &due);
+	now = (int64_t)due.tv_sec*1000000000 + due.tv_nsec;
+	if(source_fps > 0){
+
+		/*
+		** due time of frame mem_seq, skip the frames that are
+		** already overdue in latest frame mode
+		*/
+		t0 = (int64_t)mem_t0.tv_sec*1000000000 + mem_t0.tv_nsec;
+		t_due = t0 + (int64_t)(mem_seq*1000000000.0/source_fps);
+		late = (int64_t)((now - t0)*source_fps/1000000000.0);
+		if(latest && late > mem_seq){
+			frames_dropped += late - mem_seq;
+			mem_seq = late;
+			t_due = t0 + (int64_t)(mem_seq*1000000000.0/source_fps);
+		}/*eo if*/
+		if(t_due > now){
+			due.tv_sec = t_due/1000000000;
+			due.tv_nsec = t_due%1000000000;
+			while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, 
+					      &due, NULL) == EINTR)
+				;
+		}/*eo if*/
+		now = t_due;
+
+	}/*eo if*/
+	buf->timestamp.tv_sec = now/1000000000;
+	buf->timestamp.tv_usec = now%1000000000/1000;
+	buf->sequence = mem_seq;
+	buf->index = mem_slot;
+	buf->bytesused = mem_frame_size;
+
+	cap_buf[mem_slot] = mem_frames + (mem_seq%mem_nframes)*mem_frame_size;
+	atomic_store(&mem_free[mem_slot], 0);
+	cap_queued--;
+	mem_slot = (mem_slot + 1)%nbufs;
+	mem_seq++;
+
+	return(0);
+
+}/*eo mem_next*/
+
+static int mem_release(int index){
+
+	atomic_store(&mem_free[index], 1);
+	if(atomic_fetch_add(&cap_queued, 1) == 0)
+		futex_wake(&cap_queued);
+
+	return(0);
+
+}/*eo mem_release*/
+
+static void mem_close(void){
+
+	if(mem_mapped)
+		munmap(mem_frames, mem_size);
+	else
+		free(mem_frames);
+	mem_frames = NULL;
+
+}/*eo mem_close*/
+
+/*
+** process_frame
+** convert the captured yuyv422 frame and transform it
+*/
+int process_frame(struct frame *f){
+
+	/*
+	** luma only, one 8 bit channel through the haar dwt
+	*/
+	if(gray){
+		LumaExtract(f->yuyv, f->rgb565);
+		frame_stamp(f, STAMP_CONVERT);
+		HaarDwtGray(f->rgb565, (uint8_t *)f->dwt);
+		frame_stamp(f, STAMP_DWT);
+		return(0);
+	}/*eo if*/
+
+	/*
+	** convert and transform in one pass, the rgb565 frame is not
+	** produced
+	*/
+	if(fused){
+		frame_stamp(f, STAMP_CONVERT);
+		if(direct)
+			HaarDwtYuyvStride(f->yuyv, fb_dst, fb_stride);
+		else
+			HaarDwtYuyv(f->yuyv, f->dwt);
+		frame_stamp(f, STAMP_DWT);
+		return(0);
+	}/*eo if*/
+
+	/*
+	** convert yuyv422 to rgb565
+	*/
+	switch(convert){
+	case 2:
+		convert2(f->yuyv, f->rgb565);
+		break;
+	case 4:
+		convert4(f->yuyv, f->rgb565);
+		break;
+	case 5:
+		convert5(f->yuyv, f->rgb565);
+		break;
+	default:
+		convert3(f->yuyv, f->rgb565, lut_ptr);	
+		break;
+	}/*eo switch*/
+	frame_stamp(f, STAMP_CONVERT);
+
+	/*
+	** thresholded lifting and its inverse, the denoised frame takes
+	** the place of the haar dwt frame
+	*/
+	if(denoise){
+		DenoiseRgb565((uint16_t *)f->rgb565, f->dwt, denoise_planes, 
+			      cap_geo.width, cap_geo.height, 
+			      atomic_load(&denoise_thresh), 
+			      atomic_load(&denoise_soft));
+		frame_stamp(f, STAMP_DWT);
+		return(0);
+	}/*eo if*/
+
+	/*
+	** process image using haar dwt, in direct mode the result goes
+	** straight into the framebuffer
+	*/
+	if(threads && direct)
+		HaarDwt2((uint16_t*)f->rgb565, fb_dst, cap_geo.width, 
+			 cap_geo.height, fb_stride);
+	else if(threads)
+		HaarDwt2((uint16_t*)f->rgb565, f->dwt, cap_geo.width, 
+			 cap_geo.height, cap_geo.width);
+	else if(direct)
+		HaarDwtStride((uint16_t*)f->rgb565, fb_dst, fb_stride);
+	else
+		HaarDwt((uint16_t*)f->rgb565, f->dwt);
+	frame_stamp(f, STAMP_DWT);
+
+	return(0);
+
+}/*eo process_frame*/
+
+/*
+** display_frame
+** write a processed frame into the framebuffer
+*/
+int display_frame(struct frame *f){
+
+	/*
+	** threshold keys, at most one poll() per frame
+	*/
+	if(denoise || views)
+		display_keys();
+
+	/*
+	** direct mode, the frame is already in the framebuffer. grey
+	** frames are expanded to rgb565 on their way into it
+	*/
+	if(gray){
+		display_gray(fbp, (uint8_t *)f->dwt);
+	}else if(scale || views){
+
+		/*
+		** a new layout starts from a cleared page, with -b each 
+		** page is cleared when it is the one drawn so the page on
+		** the screen keeps the old layout until the flip. a layout
+		** that cannot be made is dropped, the old one stays
+		*/
+		if(comp.layout != view_layout || comp.band != view_band){
+			if(compose_layout(&comp, view_layout, view_band, scale,
+					  scale_stretch) < 0){
+				fprintf(stderr, "cannot lay out view %s %s on "
+					"the %dx%d framebuffer, keeping %s %s\n",
+					view_layouts[view_layout], 
+					view_bands[view_band], vinfo.xres, 
+					vinfo.yres, view_layouts[comp.layout], 
+					view_bands[comp.band]);
+				view_layout = comp.layout;
+				view_band = comp.band;
+			}else
+				comp_clear = dbuf ? 2 : 1;
+		}/*eo if*/
+		if(comp_clear > 0){
+			clear_fb_page(fbp, GRAY);
+			comp_clear--;
+		}/*eo if*/
+		compose(&comp, fbp, (uint16_t *)f->rgb565, f->dwt);
+
+	}else if(!direct){
+
+		/*
+		** display basic video stream
+		*/
+		//display_LCD4(fbp, f->rgb565);
+
+		/*
+		** display haar dwt (or denoised) video stream
+		*/
+		display_LCD4(fbp,(uint8_t*)f->dwt);
+
+	}/*eo if*/
+
+	/*
+	** telemetry into the page about to be shown, a direct frame was
+	** written around the blit engine
+	*/
+	if(osd){
+		if(direct)
+			osd_damage((vinfo.yres - cap_geo.height)/2, cap_geo.height);
+		osd_frame();
+	}/*eo if*/
+
+	/*
+	** show the finished page
+	*/
+	if(dbuf)
+		fb_flip();
+	frame_stamp(f, STAMP_DISPLAY);
+	frames_processed++;
+	latency_record(f);
+	if(osd)
+		osd_stats(f);
+
+	return(0);
+
+}/*eo display_frame*/
+
+/*
+** keys_signal
+** SIGINT or SIGTERM while the terminal is switched: restore it, then 
+** die of the signal as before
+*/
+static void keys_signal(int sig){
+
+	keys_close();
+	signal(sig, SIG_DFL);
+	raise(sig);
+
+}/*eo keys_signal*/
+
+/*
+** keys_open
+** read single keys from stdin without waiting for a newline, a terminal
+** gets echo and canonical mode switched off until keys_close(), at exit
+** or on SIGINT and SIGTERM
+*/
+int keys_open(void){
+
+	struct termios t;
+	struct sigaction sa;
+
+	keys_fd = STDIN_FILENO;
+	if(!isatty(keys_fd))
+		return(0);
+	if(tcgetattr(keys_fd, &keys_termios) < 0)
+		return(-1);
+	t = keys_termios;
+	t.c_lflag &= ~(ICANON | ECHO);
+	t.c_cc[VMIN] = 1;
+	t.c_cc[VTIME] = 0;
+	if(tcsetattr(keys_fd, TCSANOW, &t) < 0)
+		return(-1);
+	keys_tty = 1;
+	atexit(keys_close);
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = keys_signal;
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	return(0);
+
+}/*eo keys_open*/
+
+/*
+** keys_poll
+** the next key on stdin, -1 if there is none. at end of file stdin is
+** not polled again.
+*/
+int keys_poll(void){
+
+	struct pollfd pfd;
+	unsigned char c=0;
+	int n=0;
+
+	if(keys_fd < 0)
+		return(-1);
+	pfd.fd = keys_fd;
+	pfd.events = POLLIN;
+	if(poll(&pfd, 1, 0) <= 0)
+		return(-1);
+	n = read(keys_fd, &c, 1);
+	if(n <= 0){
+		keys_fd = -1;
+		return(-1);
+	}/*eo if*/
+
+	return(c);
+
+}/*eo keys_poll*/
+
+/*
+** keys_close
+** give the terminal its settings back
+*/
+void keys_close(void){
+
+	if(keys_tty){
+		tcsetattr(STDIN_FILENO, TCSANOW, &keys_termios);
+		keys_tty = 0;
+	}/*eo if*/
+	keys_fd = -1;
+
+}/*eo keys_close*/
+
+/*
+** denoise_parse
+** -d threshold[,hard|soft]
+*/
+int denoise_parse(char *spec){
+
+	char mode[8] = "soft";
+	int t=0;
+
+	if(sscanf(spec, "%d,%7s", &t, mode) < 1 || t < 0 || 
+	   t > DENOISE_MAX_THRESH)
+		return(-1);
+	if(strcmp(mode, "soft") != 0 && strcmp(mode, "hard") != 0)
+		return(-1);
+	denoise = 1;
+	denoise_thresh = t;
+	denoise_soft = strcmp(mode, "soft") == 0;
+
+	return(0);
+
+}/*eo denoise_parse*/
+
+/*
+** view_key
+** 1..4 pick the layout (dwt, raw, split, zoom), v the next one and b the
+** next zoomed subband. returns 0 for any other key.
+*/
+static int view_key(int c){
+
+	if(c >= '1' && c < '1' + NVIEW_LAYOUTS)
+		view_layout = c - '1';
+	else if(c == 'v')
+		view_layout = (view_layout + 1) % NVIEW_LAYOUTS;
+	else if(c == 'b')
+		view_band = (view_band + 1) % 4;
+	else
+		return(0);
+	if(verbose)
+		fprintf(stderr, "view %s %s\n", view_layouts[view_layout], 
+			view_bands[view_band]);
+
+	return(1);
+
+}/*eo view_key*/
+
+/*
+** display_keys
+** view keys with -V, with -d + and - step the denoise threshold, s and
+** h pick soft or hard
+*/
+void display_keys(void){
+
+	int c=0, t=0;
+
+	while((c = keys_poll()) >= 0){
+		if((views && view_key(c)) || !denoise)
+			continue;
+		t = atomic_load(&denoise_thresh);
+		switch(c){
+		case '+':
+		case '=':
+			if(t < DENOISE_MAX_THRESH) t++;
+			break;
+		case '-':
+			if(t > 0) t--;
+			break;
+		case 's':
+			atomic_store(&denoise_soft, 1);
+			break;
+		case 'h':
+			atomic_store(&denoise_soft, 0);
+			break;
+		default:
+			continue;
+		}/*eo switch*/
+		atomic_store(&denoise_thresh, t);
+		if(verbose)
+			fprintf(stderr, "denoise threshold %d %s\n", t, 
+				atomic_load(&denoise_soft) ? "soft" : "hard");
+	}/*eo while*/
+
+}/*eo display_keys*/
+
+/*
+** frame_stamp
+** record the CLOCK_MONOTONIC time a frame passed a stage
+*/
+void frame_stamp(struct frame *f, int stamp){
+
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	f->stamp[stamp] = (int64_t)ts.tv_sec*1000000000 + ts.tv_nsec;
+
+}/*eo frame_stamp*/
+
+/*
+** frame_capture_stamps
+** the driver timestamp of a dequeued buffer is the capture time when
+** it is taken from CLOCK_MONOTONIC (uvcvideo stamps the first packet of
+** the frame), otherwise the dequeue time stands in for it
+*/
+void frame_capture_stamps(struct frame *f, struct v4l2_buffer *buf){
+
+	frame_stamp(f, STAMP_DEQUEUE);
+	if((buf->flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == 
+	   V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC){
+		f->stamp[STAMP_CAPTURE] = (int64_t)buf->timestamp.tv_sec*1000000000 +
+					  buf->timestamp.tv_usec*1000;
+		driver_stamps++;
+	}else{
+		f->stamp[STAMP_CAPTURE] = f->stamp[STAMP_DEQUEUE];
+	}/*eo if*/
+
+}/*eo frame_capture_stamps*/
+
+/*
+** latency buckets
+** values below 2^LAT_SUB_BITS us have their own bucket, above that every
+** power of 2 is split into 2^LAT_SUB_BITS buckets, the last one ends
+** at UINT32_MAX
+*/
+int lat_bucket(uint32_t us){
+
+	int shift=0;
+
+	if(us < (1 << LAT_SUB_BITS))
+		return(us);
+	shift = 31 - __builtin_clz(us) - LAT_SUB_BITS;
+
+	return((shift << LAT_SUB_BITS) + (us >> shift));
+
+}/*eo lat_bucket*/
+
+/*
+** largest value that falls into a bucket
+*/
+uint32_t lat_bucket_max(int bucket){
+
+	int shift = (bucket >> LAT_SUB_BITS) - 1;
+
+	if(shift <= 0)
+		return(bucket);
+
+	return((((uint32_t)(bucket - (shift << LAT_SUB_BITS)) + 1) << shift) - 1);
+
+}/*eo lat_bucket_max*/
+
+void lat_add(struct latency_hist *h, int64_t ns){
+
+	uint32_t us = ns <= 0 ? 0 : ns/1000 > UINT32_MAX ? UINT32_MAX : ns/1000;
+
+	h->bucket[lat_bucket(us)]++;
+	h->count++;
+	if(us > h->max_us) h->max_us = us;
+
+}/*eo lat_add*/
+
+/*
+** latency_record
+** add a displayed frame to the stage and end-to-end histograms. only
+** the display stage calls it, so no locking is needed
+*/
+void latency_record(struct frame *f){
+
+	int i=0;
+
+	for(i=0; i<LAT_TOTAL; i++)
+		lat_add(&latency[i], f->stamp[i+1] - f->stamp[i]);
+	lat_add(&latency[LAT_TOTAL], 
+		f->stamp[STAMP_DISPLAY] - f->stamp[STAMP_CAPTURE]);
+
+}/*eo latency_record*/
+
+/*
+** percentile p (0..100) of a histogram in ms, the upper edge of the
+** bucket holding it
+*/
+static double lat_percentile(struct latency_hist *h, double p){
+
+	long rank = (long)ceil(p/100.0*h->count), n=0;
+	int i=0;
+
+	if(rank < 1) rank = 1;
+	for(i=0; i<LAT_BUCKETS; i++){
+		n += h->bucket[i];
+		if(n >= rank){
+			if(lat_bucket_max(i) > h->max_us)
+				return(h->max_us/1000.0);
+			return(lat_bucket_max(i)/1000.0);
+		}/*eo if*/
+	}/*eo for*/
+
+	return(h->max_us/1000.0);
+
+}/*eo lat_percentile*/
+
+/*
+** latency_report
+** p50/p95/p99/max per stage and end-to-end against the latency budget
+*/
+void latency_report(void){
+
+	struct latency_hist *h=NULL;
+	long over=0;
+	int i=0;
+
+	if(latency[LAT_TOTAL].count == 0)
+		return;
+
+	printf("%-16s %8s %8s %8s %8s  (ms, %ld frames)\n", "latency", "p50", 
+	       "p95", "p99", "max", latency[LAT_TOTAL].count);
+	for(i=0; i<NSTAMPS; i++){
+		h = &latency[i];
+		printf("%-16s %8.2f %8.2f %8.2f %8.2f\n", h->name, 
+		       lat_percentile(h, 50), lat_percentile(h, 95),
+		       lat_percentile(h, 99), h->max_us/1000.0);
+	}/*eo for*/
+
+	/*
+	** part of the display stage spent in the page flip
+	*/
+	h = &flip_latency;
+	if(h->count)
+		printf("%-16s %8.2f %8.2f %8.2f %8.2f\n", h->name, 
+		       lat_percentile(h, 50), lat_percentile(h, 95),
+		       lat_percentile(h, 99), h->max_us/1000.0);
+
+	/*
+	** overlay drawing, part of the display stage
+	*/
+	h = &osd_latency;
+	if(h->count){
+		for(i=lat_bucket(OSD_BUDGET_US); i<LAT_BUCKETS; i++)
+			over += h->bucket[i];
+		printf("%-16s p50 %.0f p99 %.0f max %u us, %ld frames over the "
+		       "%d us budget\n", h->name, lat_percentile(h, 50)*1000,
+		       lat_percentile(h, 99)*1000, h->max_us, over, 
+		       OSD_BUDGET_US);
+		over = 0;
+	}/*eo if*/
+
+	h = &latency[LAT_TOTAL];
+	for(i=lat_bucket(LATENCY_BUDGET_MS*1000); i<LAT_BUCKETS; i++)
+		over += h->bucket[i];
+	printf("%ld frames over the %d ms budget%s\n", over, LATENCY_BUDGET_MS,
+	       driver_stamps ? "" : 
+	       " (no monotonic driver timestamps, measured from dequeue)");
+
+}/*eo latency_report*/
+
+/*
+** osd_frame
+** draw the overlay cells that need it, its time goes into osd_latency
+*/
+void osd_frame(void){
+
+	struct timespec t0, t1;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	osd_draw(fbp, OSD_BUDGET_US);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	lat_add(&osd_latency, (int64_t)(t1.tv_sec - t0.tv_sec)*1000000000 + 
+		(t1.tv_nsec - t0.tv_nsec));
+
+}/*eo osd_frame*/
+
+/*
+** osd_stats
+** moving averages over about eight displayed frames of the stage and
+** end-to-end times and the frame rate, new overlay text every 
+** OSD_REFRESH_MS
+*/
+void osd_stats(struct frame *f){
+
+	static double ms[NSTAMPS], rate=0;
+	static int64_t last_display=0, last_text=0;
+	int64_t now = f->stamp[STAMP_DISPLAY];
+	int i=0;
+
+	for(i=0; i<LAT_TOTAL; i++)
+		ms[i] += ((f->stamp[i+1] - f->stamp[i])/1e6 - ms[i])/8;
+	ms[LAT_TOTAL] += ((now - f->stamp[STAMP_CAPTURE])/1e6 - 
+			  ms[LAT_TOTAL])/8;
+	if(last_display && now > last_display)
+		rate += (1e9/(now - last_display) - rate)/8;
+	last_display = now;
+
+	if(now - last_text < (int64_t)OSD_REFRESH_MS*1000000)
+		return;
+	last_text = now;
+	osd_printf(0, "%5.1f FPS %6ld DROP %6.1f MS", rate, frames_dropped,
+		   ms[LAT_TOTAL]);
+	osd_printf(1, "DQ %4.1f CVT %4.1f DWT %4.1f DSP %4.1f", 
+		   ms[STAMP_CAPTURE], ms[STAMP_DEQUEUE], ms[STAMP_CONVERT], 
+		   ms[STAMP_DWT]);
+
+}/*eo osd_stats*/
+
+/*
+** futex_wait
+** sleep while *addr holds val, at most ms milliseconds. returns at once
+** if the value has changed already.
+*/
+void futex_wait(_Atomic int *addr, int val, int ms){
+
+	struct timespec ts;
+
+	ts.tv_sec = ms/1000;
+	ts.tv_nsec = (long)(ms%1000)*1000000;
+	syscall(SYS_futex, (int *)addr, FUTEX_WAIT_PRIVATE, val, &ts, NULL, 0);
+
+}/*eo futex_wait*/
+
+/*
+** futex_wake
+** wake the thread sleeping on addr
+*/
+void futex_wake(_Atomic int *addr){
+
+	syscall(SYS_futex, (int *)addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+
+}/*eo futex_wake*/
+
+/*
+** spsc_wake
+** wake the consumer of q, a sleep that has not started yet sees the new
+** seq and returns
+*/
+static void spsc_wake(struct spsc_queue *q){
+
+	atomic_store(&q->waiting, 0);
+	atomic_fetch_add(&q->seq, 1);
+	futex_wake(&q->seq);
+
+}/*eo spsc_wake*/
+
+/*
+** spsc_push
+** producer side, returns -1 if the queue is full
+*/
+int spsc_push(struct spsc_queue *q, struct frame *f){
+
+	unsigned int head = atomic_load_explicit(&q->head, memory_order_relaxed);
+	unsigned int tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+
+	if(head - tail == SPSC_SIZE)
+		return(-1);
+
+	q->slot[head & (SPSC_SIZE-1)] = f;
+	atomic_store_explicit(&q->head, head+1, memory_order_release);
+
+	/*
+	** the fence pairs with the one in spsc_wait, either the consumer
+	** sees the frame or the producer sees it waiting
+	*/
+	atomic_thread_fence(memory_order_seq_cst);
+	if(atomic_load_explicit(&q->waiting, memory_order_relaxed))
+		spsc_wake(q);
+
+	return(0);
+
+}/*eo spsc_push*/
+
+/*
+** spsc_pop
+** consumer side, returns NULL if the queue is empty
+*/
+struct frame *spsc_pop(struct spsc_queue *q){
+
+	unsigned int tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+	unsigned int head = atomic_load_explicit(&q->head, memory_order_acquire);
+	struct frame *f=NULL;
+
+	if(head == tail)
+		return(NULL);
+
+	/*
+	** queue occupancy seen by the consumer
+	*/
+	q->occ_sum += head - tail;
+	q->occ_samples++;
+	if(head - tail > q->occ_max) q->occ_max = head - tail;
+
+	f = q->slot[tail & (SPSC_SIZE-1)];
+	atomic_store_explicit(&q->tail, tail+1, memory_order_release);
+
+	return(f);
+
+}/*eo spsc_pop*/
+
+/*
+** spsc_wait
+** pop a frame, polling the queue spsc_spin times and then sleeping on 
+** its futex while it is empty. returns NULL once the pipeline is 
+** stopping.
+*/
+static struct frame *spsc_wait(struct spsc_queue *q){
+
+	struct frame *f=NULL;
+	int spin=0, seq=0;
+
+	while((f = spsc_pop(q)) == NULL){
+		if(atomic_load(&pipe_stop))
+			return(NULL);
+		if(spin++ < spsc_spin)
+			continue;
+
+		/*
+		** announce the sleep, then look once more so a frame pushed
+		** in between is not slept through
+		*/
+		seq = atomic_load(&q->seq);
+		atomic_store(&q->waiting, 1);
+		atomic_thread_fence(memory_order_seq_cst);
+		if((f = spsc_pop(q)) != NULL)
+			break;
+		futex_wait(&q->seq, seq, PIPE_WAIT_MS);
+	}/*eo while*/
+	atomic_store(&q->waiting, 0);
+
+	return(f);
+
+}/*eo spsc_wait*/
+
+/*
+** pipe_halt
+** stop the pipeline and wake every stage that sleeps
+*/
+static void pipe_halt(void){
+
+	atomic_store(&pipe_stop, 1);
+	spsc_wake(&free_q);
+	spsc_wake(&cap_q);
+	spsc_wake(&proc_q);
+	futex_wake(&cap_queued);
+
+}/*eo pipe_halt*/
+
+/*
+** elapsed seconds between two CLOCK_MONOTONIC samples
+*/
+static double ts_diff(struct timespec *a, struct timespec *b){
+
+	return((b->tv_sec - a->tv_sec) + 
+	       (double)(b->tv_nsec - a->tv_nsec)/1000000000.0);
+
+}/*eo ts_diff*/
+
+/*
+** capture stage
+** take a free frame, fill it from the camera, pass it to process
+*/
+static void *capture_stage(void *arg){
+
+	struct frame *f=NULL;
+	struct v4l2_buffer buf;
+	struct timespec t0, t1;
+
+	(void)arg;
+
+	while((f = spsc_wait(&free_q)) != NULL){
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		if(capture_next(&buf) < 0){
+			pipe_halt();
+			break;
+		}/*eo if*/
+		f->index = buf.index;
+		f->yuyv = cap_buf[buf.index];
+		frame_capture_stamps(f, &buf);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		stage_busy[0] += ts_diff(&t0, &t1);
+
+		spsc_push(&cap_q, f);
+
+	}/*eo while*/
+
+	return(NULL);
+
+}/*eo capture_stage*/
+
+/*
+** process stage
+** convert and transform, then return the v4l2 buffer to the camera
+*/
+static void *process_stage(void *arg){
+
+	struct frame *f=NULL;
+	struct timespec t0, t1;
+
+	(void)arg;
+
+	while((f = spsc_wait(&cap_q)) != NULL){
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		process_frame(f);
+		if(capture_release(f->index) < 0){
+			pipe_halt();
+			break;
+		}/*eo if*/
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		stage_busy[1] += ts_diff(&t0, &t1);
+
+		spsc_push(&proc_q, f);
+
+	}/*eo while*/
+
+	return(NULL);
+
+}/*eo process_stage*/
+
+/*
+** run_pipeline
+** run capture and process in their own threads and display in the
+** calling thread until nframes have been displayed (0 = forever)
+*/
+int run_pipeline(int nframes){
+
+	struct frame frames[PIPE_FRAMES];
+	struct frame *f=NULL;
+	pthread_t cap_thread, proc_thread;
+	struct timespec t0, t1;
+	int i=0, displayed=0;
+
+	/*
+	** preallocate the frames, all start out free
+	*/
+	for(i=0; i<PIPE_FRAMES; i++){
+		frames[i].index = -1;
+		frames[i].yuyv = NULL;
+		frames[i].rgb565 = malloc(cap_geo.width*cap_geo.height*2);
+		frames[i].dwt = malloc(cap_geo.width*cap_geo.height*2);
+		if(frames[i].rgb565 == NULL || frames[i].dwt == NULL){
+			printf("pipeline - malloc failed\n");
+			return(-1);
+		}/*eo if*/
+		memset(frames[i].dwt, 0xff, cap_geo.width*cap_geo.height*2);
+		spsc_push(&free_q, &frames[i]);
+	}/*eo for*/
+
+	atomic_store(&pipe_stop, 0);
+	spsc_spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPSC_SPIN : 0;
+	if(pthread_create(&cap_thread, NULL, capture_stage, NULL) != 0 ||
+	   pthread_create(&proc_thread, NULL, process_stage, NULL) != 0){
+		printf("pipeline - pthread_create failed\n");
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** display stage
+	*/
+	while(nframes == 0 || displayed < nframes){
+
+		if((f = spsc_wait(&proc_q)) == NULL)
+			break;
+
+		clock_gettime(CLOCK_MONOTONIC, &t0);
+		display_frame(f);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		stage_busy[2] += ts_diff(&t0, &t1);
+		displayed++;
+
+		spsc_push(&free_q, f);
+
+	}/*eo while*/
+
+	/*
+	** stop the stages, the capture stage finishes its current dequeue
+	*/
+	pipe_halt();
+	pthread_join(cap_thread, NULL);
+	pthread_join(proc_thread, NULL);
+
+	/*
+	** frames still holding a v4l2 buffer give it back to the camera
+	*/
+	while((f = spsc_pop(&cap_q)) != NULL)
+		capture_release(f->index);
+
+	for(i=0; i<PIPE_FRAMES; i++){
+		free(frames[i].rgb565);
+		free(frames[i].dwt);
+	}/*eo for*/
+
+	return(displayed == nframes || nframes == 0 ? 0 : -1);
+
+}/*eo run_pipeline*/
+
+/*
+** lut_load
+** map the yuv2rgb.lut look up table used by convert3() and check its
+** header and checksum. summing the table also faults in every page, so
+** the first frames do not.
+*/
+int lut_load(char *path){
+
+	struct stat st;
+	struct lut_header *hdr=NULL;
+	char *err=NULL;
+
+	/*
+	** use yuv2rgb look up table
+	*/
+	lut_fd = open(path, O_RDONLY);
+	if(lut_fd < 0){
+		printf("yuv2rgb.lut open failed errno=%d\n", errno);
+		return(-1);
+	}/*eo if*/
+	if(fstat(lut_fd, &st) < 0 || st.st_size != LUT_OFFSET + lut_size){
+		printf("%s: not a yuv2rgb.lut, %ld bytes instead of %d\n", path, 
+		       (long)st.st_size, LUT_OFFSET + lut_size);
+		close(lut_fd);
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** read yuv2rgb.lut into virtual memory for random access by convert3()
+	** changed MAP_SHARED to MAP_RIVATE | MAP_POPULATE for 0.1s per frame performance improvemnt
+	*/	
+	hdr = mmap(NULL, LUT_OFFSET + lut_size, PROT_READ, 
+		   MAP_PRIVATE | MAP_POPULATE, lut_fd, 0);
+	if(hdr == MAP_FAILED){
+		printf("lut - mmap failed errno=%d\n", errno);
+		close(lut_fd);
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** use madvise() for mmap() performance improvement
+	*/
+	madvise(hdr, LUT_OFFSET + lut_size, MADV_WILLNEED);
+
+	/*
+	** the table must be a complete lut.c table of the bgr565 pixels
+	** yuv422_to_rgb565() produces
+	*/
+	if(memcmp(hdr->magic, LUT_MAGIC, sizeof(hdr->magic)) != 0 || 
+	   hdr->version != LUT_VERSION)
+		err = "no yuv2rgb.lut version 1 header, regenerate it with lut";
+	else if(hdr->colorspace != LUT_BT601 || hdr->entries != LUT_ENTRIES)
+		err = "not an ITU-R 601 table of 256*256*256 entries";
+	else if(hdr->order != LUT_BGR565)
+		err = "rgb565 table, sv5 needs bgr565 (lut -p bgr)";
+	else if(lut_checksum((uint16_t *)((uint8_t *)hdr + LUT_OFFSET), 
+			     LUT_ENTRIES) != hdr->checksum)
+		err = "checksum mismatch, the table is corrupt";
+	if(err){
+		printf("%s: %s\n", path, err);
+		munmap(hdr, LUT_OFFSET + lut_size);
+		close(lut_fd);
+		return(-1);
+	}/*eo if*/
+
+	lut_hdr = hdr;
+	lut_ptr = (uint16_t *)((uint8_t *)hdr + LUT_OFFSET);
+
+	/*
+	** the huge page copy replaces the file mapping
+	*/
+	if(lut_huge){
+		if(lut_hugepages() < 0)
+			return(-1);
+		munmap(hdr, LUT_OFFSET + lut_size);
+		close(lut_fd);
+		lut_hdr = NULL;
+	}/*eo if*/
+
+	return(0);
+
+}/*eo lut_load*/
+
+/*
+** huge_page_size
+** default huge page size from /proc/meminfo, 2 MB if it is not there
+*/
+static long huge_page_size(void){
+
+	FILE *fp = fopen("/proc/meminfo", "r");
+	char line[128];
+	long kb = 2048;
+
+	if(fp == NULL)
+		return(kb*1024);
+	while(fgets(line, sizeof(line), fp)){
+		if(sscanf(line, "Hugepagesize: %ld kB", &kb) == 1)
+			break;
+	}/*eo while*/
+	fclose(fp);
+
+	return(kb*1024);
+
+}/*eo huge_page_size*/
+
+/*
+** lut_hugepages
+** copy the table into huge pages and lock it, so that convert3() walks
+** 16 pages of 2 MB instead of 8192 of 4 kB. MAP_HUGETLB needs pages
+** reserved in vm.nr_hugepages, without them an anonymous mapping aligned
+** to the huge page size is advised MADV_HUGEPAGE and the kernel backs it
+** with transparent huge pages where it can. the old table is left alone.
+*/
+int lut_hugepages(void){
+
+	long huge = huge_page_size();
+	size_t size = (lut_size + huge - 1)/huge*huge;
+	uint8_t *p=NULL;
+
+	p = mmap(NULL, size, PROT_READ | PROT_WRITE, 
+		 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if(p != MAP_FAILED){
+		lut_map = p;
+		lut_map_size = size;
+		lut_mode = "MAP_HUGETLB";
+	}else{
+		p = mmap(NULL, size + huge, PROT_READ | PROT_WRITE, 
+			 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(p == MAP_FAILED){
+			printf("lut - huge page mmap failed errno=%d\n", errno);
+			return(-1);
+		}/*eo if*/
+		lut_map = p;
+		lut_map_size = size + huge;
+		p = (uint8_t *)(((uintptr_t)p + huge - 1) & ~(uintptr_t)(huge - 1));
+		if(madvise(p, size, MADV_HUGEPAGE) < 0)
+			printf("lut - MADV_HUGEPAGE failed errno=%d\n", errno);
+		lut_mode = "MADV_HUGEPAGE";
+	}/*eo if*/
+
+	/*
+	** the copy faults the pages in, mlock keeps them
+	*/
+	memcpy(p, lut_ptr, lut_size);
+	if(mlock(p, size) < 0)
+		printf("lut - mlock failed errno=%d, raise ulimit -l\n", errno);
+	lut_ptr = (uint16_t *)p;
+
+	return(0);
+
+}/*eo lut_hugepages*/
+
+/*
+** lut_report
+** mapping, kernel page size, transparent huge page and locked share of
+** the table from /proc/self/smaps
+*/
+void lut_report(FILE *fp){
+
+	FILE *sm = fopen("/proc/self/smaps", "r");
+	char line[256];
+	unsigned long start=0, end=0, addr=(unsigned long)lut_ptr;
+	long page=0, thp=0, locked=0, kb=0;
+	int in=0;
+
+	while(sm && fgets(line, sizeof(line), sm)){
+		if(sscanf(line, "%lx-%lx ", &start, &end) == 2){
+			in = addr >= start && addr < end;
+			continue;
+		}/*eo if*/
+		if(in == 0) continue;
+		if(sscanf(line, "KernelPageSize: %ld kB", &kb) == 1) page = kb;
+		if(sscanf(line, "AnonHugePages: %ld kB", &kb) == 1) thp += kb;
+		if(sscanf(line, "Locked: %ld kB", &kb) == 1) locked += kb;
+	}/*eo while*/
+	if(sm) fclose(sm);
+
+	fprintf(fp, "lut: %s, %ld kB kernel pages, %ld of %d kB in "
+		"transparent huge pages, %ld kB locked\n", lut_mode, page, thp,
+		lut_size/1024, locked);
+
+}/*eo lut_report*/
+
+/*
+** haar_channel
+** one channel of the HaarDwt 2x2 window, same arithmetic, clamps and
+** 8 bit truncation of the x10 detail gain as HaarDwt
+*/
+static inline void haar_channel(int r1c1, int r1c2, int r2c1, int r2c2, 
+				int max, uint8_t *ll, uint8_t *lh, uint8_t *hl,
+				uint8_t *hh){
+
+	int lp1=0,lp2=0,lp3=0;
+	int hp1=0,hp2=0,hp3=0;
+
+	lp1 = (r1c1+r2c1)/2; if(lp1>max) lp1=max;
+	lp2 = (r1c2+r2c2)/2; if(lp2>max) lp2=max;
+	lp3 = (lp1+lp2)/2; if(lp3>max) lp3=max;
+	*ll = lp3;
+
+	hp1 = abs((lp1-lp2)/2); if(hp1>max) hp1=max;
+	*lh = hp1*10;
+
+	hp1 = abs((r1c1-r2c1)/2); if(hp1>max) hp1=max;
+	hp2 = abs((r1c2-r2c2)/2); if(hp2>max) hp2=max;
+	lp1 = (hp1+hp2)/2; if(lp1>max) lp1=max;
+	*hl = lp1*10;
+
+	hp3 = abs((hp1-hp2)/2); if(hp3>max) hp3=max;
+	*hh = hp3*10;
+
+}/*eo haar_channel*/
+
+/*
+** haar_rows
+** HaarDwt of one pair of rgb565 rows (ncols even) into one row of each
+** of the ll,lh,hl,hh quadrants
+*/
+static inline void haar_rows(const uint16_t *r1, const uint16_t *r2, 
+			     uint16_t *ll_ptr, uint16_t *lh_ptr, 
+			     uint16_t *hl_ptr, uint16_t *hh_ptr, int ncols){
+
+	uint8_t red_ll, red_lh, red_hl, red_hh;
+	uint8_t grn_ll, grn_lh, grn_hl, grn_hh;
+	uint8_t blu_ll, blu_lh, blu_hl, blu_hh;
+	int r1c1, r1c2, r2c1, r2c2;
+	int k=0;
+
+	for(k=0; k<ncols/2; k++){
+
+		r1c1 = r1[2*k];
+		r1c2 = r1[2*k+1];
+		r2c1 = r2[2*k];
+		r2c2 = r2[2*k+1];
+
+		haar_channel(r1c1>>11, r1c2>>11, r2c1>>11, r2c2>>11, 0x1f,
+			     &red_ll, &red_lh, &red_hl, &red_hh);
+		haar_channel((r1c1>>5)&0x3f, (r1c2>>5)&0x3f, 
+			     (r2c1>>5)&0x3f, (r2c2>>5)&0x3f, 0x3f,
+			     &grn_ll, &grn_lh, &grn_hl, &grn_hh);
+		haar_channel(r1c1&0x1f, r1c2&0x1f, r2c1&0x1f, r2c2&0x1f, 0x1f,
+			     &blu_ll, &blu_lh, &blu_hl, &blu_hh);
+
+		ll_ptr[k] = ((red_ll << 11) | (grn_ll << 5) | (blu_ll));
+		lh_ptr[k] = ((red_lh << 11) | (grn_lh << 5) | (blu_lh));
+		hl_ptr[k] = ((red_hl << 11) | (grn_hl << 5) | (blu_hl));
+		hh_ptr[k] = ((red_hh << 11) | (grn_hh << 5) | (blu_hh));
+
+	}/*eo for*/
+
+}/*eo haar_rows*/
+
+/*
+** haar_rows_scalar
+** haar_rows as a kernel for the simd dispatch and the simd tails
+*/
+static void haar_rows_scalar(const uint16_t *r1, const uint16_t *r2, 
+			     uint16_t *ll_ptr, uint16_t *lh_ptr, 
+			     uint16_t *hl_ptr, uint16_t *hh_ptr, int ncols){
+
+	haar_rows(r1, r2, ll_ptr, lh_ptr, hl_ptr, hh_ptr, ncols);
+
+}/*eo haar_rows_scalar*/
+
+/*
+** simd haar_rows
+** the HaarDwt channel values are small and non-negative, so every step
+** maps onto 16 bit lanes: (a+c)/2 is a shift, abs((a-c)/2) is
+** abs(a-c)>>1, the x10 detail gain is truncated to 8 bits with a mask
+** and the 16 bit packing drops the same bits as the uint16_t store.
+** the result is byte-identical to haar_rows().
+*/
+void (*haar_rows_simd)(const uint16_t *r1, const uint16_t *r2, 
+		       uint16_t *ll_ptr, uint16_t *lh_ptr, uint16_t *hl_ptr,
+		       uint16_t *hh_ptr, int ncols) = haar_rows_scalar;
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/*
+** one channel of eight windows
+*/
+static inline void haar_channel_sse2(__m128i a, __m128i b, __m128i c, 
+				     __m128i d, __m128i *ll, __m128i *lh, 
+				     __m128i *hl, __m128i *hh){
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ten = _mm_set1_epi16(10);
+	const __m128i mask = _mm_set1_epi16(0xff);
+	__m128i lp1, lp2, hp1, hp2, t;
+
+	lp1 = _mm_srli_epi16(_mm_add_epi16(a, c), 1);
+	lp2 = _mm_srli_epi16(_mm_add_epi16(b, d), 1);
+	*ll = _mm_srli_epi16(_mm_add_epi16(lp1, lp2), 1);
+
+	t = _mm_sub_epi16(lp1, lp2);
+	t = _mm_srli_epi16(_mm_max_epi16(t, _mm_sub_epi16(zero, t)), 1);
+	*lh = _mm_and_si128(_mm_mullo_epi16(t, ten), mask);
+
+	t = _mm_sub_epi16(a, c);
+	hp1 = _mm_srli_epi16(_mm_max_epi16(t, _mm_sub_epi16(zero, t)), 1);
+	t = _mm_sub_epi16(b, d);
+	hp2 = _mm_srli_epi16(_mm_max_epi16(t, _mm_sub_epi16(zero, t)), 1);
+	t = _mm_srli_epi16(_mm_add_epi16(hp1, hp2), 1);
+	*hl = _mm_and_si128(_mm_mullo_epi16(t, ten), mask);
+
+	t = _mm_sub_epi16(hp1, hp2);
+	t = _mm_srli_epi16(_mm_max_epi16(t, _mm_sub_epi16(zero, t)), 1);
+	*hh = _mm_and_si128(_mm_mullo_epi16(t, ten), mask);
+
+}/*eo haar_channel_sse2*/
+
+/*
+** split 16 rgb565 pixels into the even (c1) and odd (c2) columns
+*/
+static inline void haar_deinterleave_sse2(const uint16_t *p, __m128i *c1, 
+					  __m128i *c2){
+
+	__m128i a0 = _mm_loadu_si128((__m128i *)p);
+	__m128i a1 = _mm_loadu_si128((__m128i *)(p+8));
+
+	*c1 = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a0, 16), 16),
+			      _mm_srai_epi32(_mm_slli_epi32(a1, 16), 16));
+	*c2 = _mm_packs_epi32(_mm_srai_epi32(a0, 16), _mm_srai_epi32(a1, 16));
+
+}/*eo haar_deinterleave_sse2*/
+
+/*
+** eight windows per iteration
+*/
+static void haar_rows_sse2(const uint16_t *r1, const uint16_t *r2, 
+			   uint16_t *ll_ptr, uint16_t *lh_ptr, 
+			   uint16_t *hl_ptr, uint16_t *hh_ptr, int ncols){
+
+	const __m128i m5 = _mm_set1_epi16(0x1f), m6 = _mm_set1_epi16(0x3f);
+	__m128i r1c1, r1c2, r2c1, r2c2;
+	__m128i red[4], grn[4], blu[4];
+	int k=0;
+
+	for(k=0; k+8<=ncols/2; k+=8){
+
+		haar_deinterleave_sse2(r1 + 2*k, &r1c1, &r1c2);
+		haar_deinterleave_sse2(r2 + 2*k, &r2c1, &r2c2);
+
+		haar_channel_sse2(_mm_srli_epi16(r1c1, 11), _mm_srli_epi16(r1c2, 11),
+				  _mm_srli_epi16(r2c1, 11), _mm_srli_epi16(r2c2, 11),
+				  &red[0], &red[1], &red[2], &red[3]);
+		haar_channel_sse2(_mm_and_si128(_mm_srli_epi16(r1c1, 5), m6),
+				  _mm_and_si128(_mm_srli_epi16(r1c2, 5), m6),
+				  _mm_and_si128(_mm_srli_epi16(r2c1, 5), m6),
+				  _mm_and_si128(_mm_srli_epi16(r2c2, 5), m6),
+				  &grn[0], &grn[1], &grn[2], &grn[3]);
+		haar_channel_sse2(_mm_and_si128(r1c1, m5), _mm_and_si128(r1c2, m5),
+				  _mm_and_si128(r2c1, m5), _mm_and_si128(r2c2, m5),
+				  &blu[0], &blu[1], &blu[2], &blu[3]);
+
+#define HAAR_PACK_SSE2(q) _mm_or_si128(_mm_slli_epi16(red[q], 11), \
+			  _mm_or_si128(_mm_slli_epi16(grn[q], 5), blu[q]))
+		_mm_storeu_si128((__m128i *)(ll_ptr + k), HAAR_PACK_SSE2(0));
+		_mm_storeu_si128((__m128i *)(lh_ptr + k), HAAR_PACK_SSE2(1));
+		_mm_storeu_si128((__m128i *)(hl_ptr + k), HAAR_PACK_SSE2(2));
+		_mm_storeu_si128((__m128i *)(hh_ptr + k), HAAR_PACK_SSE2(3));
+#undef HAAR_PACK_SSE2
+
+	}/*eo for*/
+
+	if(k < ncols/2)
+		haar_rows(r1 + 2*k, r2 + 2*k, ll_ptr + k, lh_ptr + k, 
+			  hl_ptr + k, hh_ptr + k, ncols - 2*k);
+
+}/*eo haar_rows_sse2*/
+
+__attribute__((target("avx2")))
+static inline void haar_channel_avx2(__m256i a, __m256i b, __m256i c, 
+				     __m256i d, __m256i *ll, __m256i *lh, 
+				     __m256i *hl, __m256i *hh){
+
+	const __m256i ten = _mm256_set1_epi16(10);
+	const __m256i mask = _mm256_set1_epi16(0xff);
+	__m256i lp1, lp2, hp1, hp2, t;
+
+	lp1 = _mm256_srli_epi16(_mm256_add_epi16(a, c), 1);
+	lp2 = _mm256_srli_epi16(_mm256_add_epi16(b, d), 1);
+	*ll = _mm256_srli_epi16(_mm256_add_epi16(lp1, lp2), 1);
+
+	t = _mm256_srli_epi16(_mm256_abs_epi16(_mm256_sub_epi16(lp1, lp2)), 1);
+	*lh = _mm256_and_si256(_mm256_mullo_epi16(t, ten), mask);
+
+	hp1 = _mm256_srli_epi16(_mm256_abs_epi16(_mm256_sub_epi16(a, c)), 1);
+	hp2 = _mm256_srli_epi16(_mm256_abs_epi16(_mm256_sub_epi16(b, d)), 1);
+	t = _mm256_srli_epi16(_mm256_add_epi16(hp1, hp2), 1);
+	*hl = _mm256_and_si256(_mm256_mullo_epi16(t, ten), mask);
+
+	t = _mm256_srli_epi16(_mm256_abs_epi16(_mm256_sub_epi16(hp1, hp2)), 1);
+	*hh = _mm256_and_si256(_mm256_mullo_epi16(t, ten), mask);
+
+}/*eo haar_channel_avx2*/
+
+/*
+** the packs work within each 128 bit lane, the permute puts the
+** sixteen windows back in order
+*/
+__attribute__((target("avx2")))
+static inline void haar_deinterleave_avx2(const uint16_t *p, __m256i *c1, 
+					  __m256i *c2){
+
+	__m256i a0 = _mm256_loadu_si256((__m256i *)p);
+	__m256i a1 = _mm256_loadu_si256((__m256i *)(p+16));
+
+	*c1 = _mm256_packs_epi32(
+	      _mm256_srai_epi32(_mm256_slli_epi32(a0, 16), 16),
+	      _mm256_srai_epi32(_mm256_slli_epi32(a1, 16), 16));
+	*c2 = _mm256_packs_epi32(_mm256_srai_epi32(a0, 16), 
+				 _mm256_srai_epi32(a1, 16));
+	*c1 = _mm256_permute4x64_epi64(*c1, _MM_SHUFFLE(3,1,2,0));
+	*c2 = _mm256_permute4x64_epi64(*c2, _MM_SHUFFLE(3,1,2,0));
+
+}/*eo haar_deinterleave_avx2*/
+
+/*
+** sixteen windows per iteration
+*/
+__attribute__((target("avx2")))
+static void haar_rows_avx2(const uint16_t *r1, const uint16_t *r2, 
+			   uint16_t *ll_ptr, uint16_t *lh_ptr, 
+			   uint16_t *hl_ptr, uint16_t *hh_ptr, int ncols){
+
+	const __m256i m5 = _mm256_set1_epi16(0x1f), m6 = _mm256_set1_epi16(0x3f);
+	__m256i r1c1, r1c2, r2c1, r2c2;
+	__m256i red[4], grn[4], blu[4];
+	int k=0;
+
+	for(k=0; k+16<=ncols/2; k+=16){
+
+		haar_deinterleave_avx2(r1 + 2*k, &r1c1, &r1c2);
+		haar_deinterleave_avx2(r2 + 2*k, &r2c1, &r2c2);
+
+		haar_channel_avx2(_mm256_srli_epi16(r1c1, 11), 
+				  _mm256_srli_epi16(r1c2, 11),
+				  _mm256_srli_epi16(r2c1, 11), 
+				  _mm256_srli_epi16(r2c2, 11),
+				  &red[0], &red[1], &red[2], &red[3]);
+		haar_channel_avx2(_mm256_and_si256(_mm256_srli_epi16(r1c1, 5), m6),
+				  _mm256_and_si256(_mm256_srli_epi16(r1c2, 5), m6),
+				  _mm256_and_si256(_mm256_srli_epi16(r2c1, 5), m6),
+				  _mm256_and_si256(_mm256_srli_epi16(r2c2, 5), m6),
+				  &grn[0], &grn[1], &grn[2], &grn[3]);
+		haar_channel_avx2(_mm256_and_si256(r1c1, m5), 
+				  _mm256_and_si256(r1c2, m5),
+				  _mm256_and_si256(r2c1, m5), 
+				  _mm256_and_si256(r2c2, m5),
+				  &blu[0], &blu[1], &blu[2], &blu[3]);
+
+#define HAAR_PACK_AVX2(q) _mm256_or_si256(_mm256_slli_epi16(red[q], 11), \
+			  _mm256_or_si256(_mm256_slli_epi16(grn[q], 5), blu[q]))
+		_mm256_storeu_si256((__m256i *)(ll_ptr + k), HAAR_PACK_AVX2(0));
+		_mm256_storeu_si256((__m256i *)(lh_ptr + k), HAAR_PACK_AVX2(1));
+		_mm256_storeu_si256((__m256i *)(hl_ptr + k), HAAR_PACK_AVX2(2));
+		_mm256_storeu_si256((__m256i *)(hh_ptr + k), HAAR_PACK_AVX2(3));
+#undef HAAR_PACK_AVX2
+
+	}/*eo for*/
+
+	if(k < ncols/2)
+		haar_rows_sse2(r1 + 2*k, r2 + 2*k, ll_ptr + k, lh_ptr + k, 
+			       hl_ptr + k, hh_ptr + k, ncols - 2*k);
+
+}/*eo haar_rows_avx2*/
+
+#endif /*x86*/
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+/*
+** one channel of eight windows, vhadd is (a+b)>>1 and vabd is abs(a-b)
+*/
+static inline void haar_channel_neon(uint16x8_t a, uint16x8_t b, 
+				     uint16x8_t c, uint16x8_t d, 
+				     uint16x8_t *ll, uint16x8_t *lh,
+				     uint16x8_t *hl, uint16x8_t *hh){
+
+	const uint16x8_t mask = vdupq_n_u16(0xff);
+	uint16x8_t lp1, lp2, hp1, hp2;
+
+	lp1 = vhaddq_u16(a, c);
+	lp2 = vhaddq_u16(b, d);
+	*ll = vhaddq_u16(lp1, lp2);
+	*lh = vandq_u16(vmulq_n_u16(vshrq_n_u16(vabdq_u16(lp1, lp2), 1), 10), 
+			mask);
+
+	hp1 = vshrq_n_u16(vabdq_u16(a, c), 1);
+	hp2 = vshrq_n_u16(vabdq_u16(b, d), 1);
+	*hl = vandq_u16(vmulq_n_u16(vhaddq_u16(hp1, hp2), 10), mask);
+	*hh = vandq_u16(vmulq_n_u16(vshrq_n_u16(vabdq_u16(hp1, hp2), 1), 10), 
+			mask);
+
+}/*eo haar_channel_neon*/
+
+/*
+** eight windows per iteration, vld2 splits even and odd columns
+*/
+static void haar_rows_neon(const uint16_t *r1, const uint16_t *r2, 
+			   uint16_t *ll_ptr, uint16_t *lh_ptr, 
+			   uint16_t *hl_ptr, uint16_t *hh_ptr, int ncols){
+
+	const uint16x8_t m5 = vdupq_n_u16(0x1f), m6 = vdupq_n_u16(0x3f);
+	uint16x8x2_t p1, p2;
+	uint16x8_t red[4], grn[4], blu[4];
+	int k=0;
+
+	for(k=0; k+8<=ncols/2; k+=8){
+
+		p1 = vld2q_u16(r1 + 2*k);
+		p2 = vld2q_u16(r2 + 2*k);
+
+		haar_channel_neon(vshrq_n_u16(p1.val[0], 11), 
+				  vshrq_n_u16(p1.val[1], 11),
+				  vshrq_n_u16(p2.val[0], 11), 
+				  vshrq_n_u16(p2.val[1], 11),
+				  &red[0], &red[1], &red[2], &red[3]);
+		haar_channel_neon(vandq_u16(vshrq_n_u16(p1.val[0], 5), m6),
+				  vandq_u16(vshrq_n_u16(p1.val[1], 5), m6),
+				  vandq_u16(vshrq_n_u16(p2.val[0], 5), m6),
+				  vandq_u16(vshrq_n_u16(p2.val[1], 5), m6),
+				  &grn[0], &grn[1], &grn[2], &grn[3]);
+		haar_channel_neon(vandq_u16(p1.val[0], m5), vandq_u16(p1.val[1], m5),
+				  vandq_u16(p2.val[0], m5), vandq_u16(p2.val[1], m5),
+				  &blu[0], &blu[1], &blu[2], &blu[3]);
+
+#define HAAR_PACK_NEON(q) vorrq_u16(vshlq_n_u16(red[q], 11), \
+			  vorrq_u16(vshlq_n_u16(grn[q], 5), blu[q]))
+		vst1q_u16(ll_ptr + k, HAAR_PACK_NEON(0));
+		vst1q_u16(lh_ptr + k, HAAR_PACK_NEON(1));
+		vst1q_u16(hl_ptr + k, HAAR_PACK_NEON(2));
+		vst1q_u16(hh_ptr + k, HAAR_PACK_NEON(3));
+#undef HAAR_PACK_NEON
+
+	}/*eo for*/
+
+	if(k < ncols/2)
+		haar_rows(r1 + 2*k, r2 + 2*k, ll_ptr + k, lh_ptr + k, 
+			  hl_ptr + k, hh_ptr + k, ncols - 2*k);
+
+}/*eo haar_rows_neon*/
+
+#endif /*neon*/
+
+/*
+** HaarDwtYuyv
+** fused yuyv422 to haar dwt rgb565 transform. each pair of rows is
+** converted straight from the capture buffer into a two row strip that
+** stays in L1 cache and is transformed right away into one row of the
+** ll,lh,hl,hh quadrants in imgout_ptr. the output is identical to
+** convert3() followed by HaarDwt() but the intermediate rgb565 frame is
+** never written to or read back from memory.
+** the conversion uses convert5_pixels (init_simd() picks the simd
+** kernel, the compact tables must be initialized).
+**
+** input variables:
+** void *cbp is the yuyv422 capture buffer
+** uint16_t *imgout_ptr is the output buffer
+*/
+int HaarDwtYuyv(void *cbp, uint16_t *imgout_ptr){
+
+	return(HaarDwtYuyvStride(cbp, imgout_ptr, cap_geo.width));
+
+}/*eo HaarDwtYuyv*/
+
+/*
+** HaarDwtYuyvStride
+** HaarDwtYuyv writing into an image with a line length of out_stride
+** pixels, e.g. straight into the framebuffer
+*/
+static inline __attribute__((always_inline))
+void haar_yuyv_rows(int width, int height, uint8_t *cbp, 
+		    uint16_t *imgout_ptr, int out_stride){
+
+	uint16_t strip[2*MAX_FRAME_WIDTH];
+	uint8_t *row1=NULL;
+	uint16_t *ll_ptr=NULL;
+	int h=0;
+
+	for(h=0; h<height/2; h++){
+
+		/*
+		** convert two input rows
+		*/
+		row1 = cbp + (2*h)*cap_geo.stride;
+		convert5_pixels(row1, strip, width);
+		convert5_pixels(row1 + cap_geo.stride, strip + width, width);
+
+		/*
+		** one output row per quadrant
+		*/
+		ll_ptr = imgout_ptr + h*out_stride;
+		haar_rows_simd(strip, strip + width, ll_ptr, 
+			  ll_ptr + width/2,
+			  ll_ptr + (height/2)*out_stride,
+			  ll_ptr + (height/2)*out_stride + width/2,
+			  width);
+
+	}/*eo for*/
+
+}/*eo haar_yuyv_rows*/
+
+int HaarDwtYuyvStride(void *cbp, uint16_t *imgout_ptr, int out_stride){
+
+	GEO_SPECIALIZE(&cap_geo, haar_yuyv_rows, cbp, imgout_ptr, out_stride);
+
+	return(0);
+
+}/*eo HaarDwtYuyvStride*/
+
+/*
+** HaarDwtStride
+** HaarDwt of an rgb565 frame into an image with a line length of
+** out_stride pixels, e.g. straight into the framebuffer. the output is
+** identical to HaarDwt()
+*/
+static inline __attribute__((always_inline))
+void haar_stride_rows(int width, int height, uint16_t *imgin_ptr, 
+		      uint16_t *imgout_ptr, int out_stride){
+
+	uint16_t *row1=NULL, *ll_ptr=NULL;
+	int h=0;
+
+	for(h=0; h<height/2; h++){
+		row1 = imgin_ptr + (2*h)*width;
+		ll_ptr = imgout_ptr + h*out_stride;
+		haar_rows(row1, row1 + width, ll_ptr, 
+			  ll_ptr + width/2,
+			  ll_ptr + (height/2)*out_stride,
+			  ll_ptr + (height/2)*out_stride + width/2,
+			  width);
+	}/*eo for*/
+
+}/*eo haar_stride_rows*/
+
+int HaarDwtStride(uint16_t *imgin_ptr, uint16_t *imgout_ptr, int out_stride){
+
+	GEO_SPECIALIZE(&cap_geo, haar_stride_rows, imgin_ptr, imgout_ptr, 
+		       out_stride);
+
+	return(0);
+
+}/*eo HaarDwtStride*/
+
+/*
+** fb_origin
+** address of the top left pixel of a width x height frame centred in
+** the visible framebuffer area (vinfo.xoffset/yoffset, xres/yres,
+** finfo.line_length), or in the hidden page when double buffered. 
+** returns NULL if the frame does not fit.
+*/
+uint16_t *fb_origin(void *fbp, int width, int height){
+
+	struct blit_area a;
+
+	if(vinfo.xres < (unsigned)width || vinfo.yres < (unsigned)height ||
+	   blit_clip(fbp, NULL, width, height, &a) < 0)
+		return(NULL);
+
+	return(a.dst);
+
+}/*eo fb_origin*/
+
+/*
+** fb_geometry
+** visible framebuffer geometry from the FBIOGET_VSCREENINFO and
+** FBIOGET_FSCREENINFO results, the kernels only write rgb565
+*/
+int fb_geometry(void){
+
+	fb_geo.width = vinfo.xres;
+	fb_geo.height = vinfo.yres;
+	fb_geo.stride = finfo.line_length;
+	if(vinfo.bits_per_pixel != 16){
+		fprintf(stderr, "framebuffer is %d bits per pixel, not rgb565\n",
+			vinfo.bits_per_pixel);
+		return(-1);
+	}/*eo if*/
+	fb_geo.pixfmt = V4L2_PIX_FMT_RGB565;
+
+	return(0);
+
+}/*eo fb_geometry*/
+
+/*
+** fb_flip
+** show the page that was drawn last and draw the next frame into the
+** other one. the time from the pan request until the driver returns,
+** with -w until the vertical blank, goes into flip_latency. a driver 
+** that cannot pan leaves the output single buffered, returns -1.
+*/
+int fb_flip(void){
+
+	struct timespec t0, t1;
+	uint32_t arg=0;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	vinfo.yoffset = fb_back;
+	if(!fb_file){
+		if(ioctl(fb_fd, FBIOPAN_DISPLAY, &vinfo) < 0){
+			printf("FBIOPAN_DISPLAY error %d, single buffered\n", 
+			       errno);
+			dbuf = vsync = 0;
+			vinfo.yoffset = 0;
+			fb_dst = fb_origin(fbp, cap_geo.width, cap_geo.height);
+			return(-1);
+		}/*eo if*/
+		if(vsync && ioctl(fb_fd, FBIO_WAITFORVSYNC, &arg) < 0){
+			printf("FBIO_WAITFORVSYNC error %d, not waiting\n", 
+			       errno);
+			vsync = 0;
+		}/*eo if*/
+	}/*eo if*/
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	lat_add(&flip_latency, (int64_t)(t1.tv_sec - t0.tv_sec)*1000000000 + 
+		t1.tv_nsec - t0.tv_nsec);
+
+	fb_back = fb_back ? 0 : vinfo.yres;
+	fb_dst = fb_origin(fbp, cap_geo.width, cap_geo.height);
+
+	return(0);
+
+}/*eo fb_flip*/
+
+/*
+** fb_open_device
+** open, set to 16 bits per pixel and map a framebuffer device. double
+** buffered the virtual height is doubled if the driver has the memory.
+*/
+int fb_open_device(char *path){
+
+	if((fb_fd = open(path, O_RDWR)) < 0){
+		perror("open\n");
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** Initialize the framebuffer
+	*/
+	ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo);
+	vinfo.grayscale=0;
+	vinfo.bits_per_pixel=16;
+
+	/*
+	** a second page below the visible one, shown from page 0
+	*/
+	if(dbuf){
+		vinfo.yres_virtual = 2*vinfo.yres;
+		vinfo.yoffset = 0;
+		if(ioctl(fb_fd, FBIOPUT_VSCREENINFO, &vinfo) < 0)
+			vinfo.yres_virtual = vinfo.yres;
+	}/*eo if*/
+	if (ioctl(fb_fd, FBIOPUT_VSCREENINFO, &vinfo) < 0){
+		printf("FBIOPUT_VSCREENINFO error %d\n", errno);
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** get the framebuffer properties
+	*/
+	ioctl(fb_fd, FBIOGET_VSCREENINFO, &vinfo);	
+	ioctl(fb_fd, FBIOGET_FSCREENINFO, &finfo);	
+
+	/*
+	** calculate the framebuffer screensize
+	*/
+	screensize = vinfo.yres_virtual * finfo.line_length;
+
+	/*
+	** get the address for the framebuffer
+	*/
+	fbp = mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED, fb_fd, 0);
+	if (fbp == MAP_FAILED){
+		printf("framebuffer - mmap failed errno %d\n", errno);
+		fbp = NULL;
+		return(-1);
+	}/*eo if*/
+	fb_file = 0;
+
+	return(0);
+
+}/*eo fb_open_device*/
+
+/*
+** fb_open_file
+** use a regular file as a fake framebuffer so the direct output can be
+** checked without a display. spec is path[,width,height,line_length],
+** the default is a 480x272 panel with a 960 byte line length. double
+** buffered it is two pages high.
+*/
+int fb_open_file(char *spec){
+
+	char path[256];
+	int w=HVGA_WIDTH, h=HVGA_HEIGHT, line=0;
+
+	if(sscanf(spec, "%255[^,],%d,%d,%d", path, &w, &h, &line) < 1)
+		return(-1);
+	if(line < w*2) line = w*2;
+
+	if((fb_fd = open(path, O_RDWR | O_CREAT, 0644)) < 0){
+		perror("fake framebuffer open");
+		return(-1);
+	}/*eo if*/
+
+	/*
+	** screen info as a 16 bit per pixel driver would report it
+	*/
+	memset(&vinfo, 0, sizeof(vinfo));
+	memset(&finfo, 0, sizeof(finfo));
+	vinfo.xres = vinfo.xres_virtual = w;
+	vinfo.yres = h;
+	vinfo.yres_virtual = dbuf ? 2*h : h;
+	vinfo.bits_per_pixel = 16;
+	finfo.line_length = line;
+	screensize = vinfo.yres_virtual * finfo.line_length;
+
+	if(ftruncate(fb_fd, screensize) < 0){
+		perror("fake framebuffer ftruncate");
+		return(-1);
+	}/*eo if*/
+
+	fbp = mmap(0, screensize, PROT_READ | PROT_WRITE, MAP_SHARED, fb_fd, 0);
+	if(fbp == MAP_FAILED){
+		printf("fake framebuffer - mmap failed errno %d\n", errno);
+		fbp = NULL;
+		return(-1);
+	}/*eo if*/
+	fb_file = 1;
+
+	return(0);
+
+}/*eo fb_open_file*/
+
+/*
+** hardware performance counters
+** cycles, instructions, cache misses and dTLB read misses of the calling
+** thread in user space, counted with perf_event_open(2). a counter the
+** kernel or the cpu does not provide stays closed and reads as -1.
+*/
+char *perf_name[NPERF] = { 
+	"cycles", "instructions", "cache-misses", "dtlb-misses" 
+};
+int perf_fd[NPERF] = { -1, -1, -1, -1 };
+
+/*
+** perf_open
+** open the counters, returns -1 if none is available
+*/
+int perf_open(void){
+
+	struct perf_event_attr attr;
+	int i=0, n=0;
+
+	for(i=0; i<NPERF; i++){
+
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		switch(i){
+		case PERF_CYCLES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case PERF_INSTRUCTIONS:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case PERF_CACHE_MISSES:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CACHE_MISSES;
+			break;
+		default:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | 
+				      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+				      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		}/*eo switch*/
+
+		perf_fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+		if(perf_fd[i] >= 0) n++;
+
+	}/*eo for*/
+
+	return(n ? 0 : -1);
+
+}/*eo perf_open*/
+
+/*
+** perf_start
+** reset and start the open counters
+*/
+void perf_start(void){
+
+	int i=0;
+
+	for(i=0; i<NPERF; i++){
+		if(perf_fd[i] < 0) continue;
+		ioctl(perf_fd[i], PERF_EVENT_IOC_RESET, 0);
+		ioctl(perf_fd[i], PERF_EVENT_IOC_ENABLE, 0);
+	}/*eo for*/
+
+}/*eo perf_start*/
+
+/*
+** perf_stop
+** stop the counters and read them into val[NPERF]
+*/
+void perf_stop(long long *val){
+
+	int i=0;
+
+	for(i=0; i<NPERF; i++){
+		val[i] = -1;
+		if(perf_fd[i] < 0) continue;
+		ioctl(perf_fd[i], PERF_EVENT_IOC_DISABLE, 0);
+		if(read(perf_fd[i], &val[i], sizeof(val[i])) != sizeof(val[i]))
+			val[i] = -1;
+	}/*eo for*/
+
+}/*eo perf_stop*/
+
+void perf_close(void){
+
+	int i=0;
+
+	for(i=0; i<NPERF; i++){
+		if(perf_fd[i] >= 0) close(perf_fd[i]);
+		perf_fd[i] = -1;
+	}/*eo for*/
+
+}/*eo perf_close*/
+
+/*
+** persistent worker pool
+** pool_run() hands the same job to every thread, the caller included,
+** each one processing its own band. the workers sleep on a condition
+** variable between jobs.
+*/
+#define MAX_WORKERS	16
+
+struct worker_pool {
+	pthread_mutex_t lock;
+	pthread_cond_t start, done;
+	void (*fn)(void *arg, int band, int nbands);
+	void *arg;
+	int nthreads;		/*threads including the caller*/
+	int generation;		/*incremented for every job*/
+	int first_generation;	/*generation when the workers were started*/
+	int pending;		/*workers still busy with the job*/
+	int quit;
+	pthread_t tid[MAX_WORKERS];
+};
+
+struct worker_pool pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER, 
+	.start = PTHREAD_COND_INITIALIZER, 
+	.done = PTHREAD_COND_INITIALIZER, 
+	.nthreads = 1
+};
+
+static void *pool_worker(void *p){
+
+	int band = (int)(intptr_t)p;
+	int generation = 0;
+	void (*fn)(void *arg, int band, int nbands);
+	void *arg;
+	int nbands;
+
+	pthread_mutex_lock(&pool.lock);
+	generation = pool.first_generation;
+	for(;;){
+		while(pool.generation == generation && !pool.quit)
+			pthread_cond_wait(&pool.start, &pool.lock);
+		if(pool.quit)
+			break;
+		generation = pool.generation;
+		fn = pool.fn;
+		arg = pool.arg;
+		nbands = pool.nthreads;
+		pthread_mutex_unlock(&pool.lock);
+
+		fn(arg, band, nbands);
+
+		pthread_mutex_lock(&pool.lock);
+		if(--pool.pending == 0)
+			pthread_cond_signal(&pool.done);
+	}/*eo for*/
+	pthread_mutex_unlock(&pool.lock);
+
+	return(NULL);
+
+}/*eo pool_worker*/
+
+/*
+** pool_init
+** start nthreads-1 workers, the caller is the remaining thread
+*/
+int pool_init(int nthreads){
+
+	int i=0;
+
+	if(nthreads < 1) nthreads = 1;
+	if(nthreads > MAX_WORKERS) nthreads = MAX_WORKERS;
+
+	/*
+	** a worker that gets the lock after the first pool_run() must still
+	** see that job as new
+	*/
+	pool.quit = 0;
+	pool.nthreads = 1;
+	pool.first_generation = pool.generation;
+	for(i=1; i<nthreads; i++){
+		if(pthread_create(&pool.tid[i], NULL, pool_worker, 
+				  (void *)(intptr_t)i) != 0){
+			printf("pool - pthread_create failed\n");
+			return(-1);
+		}/*eo if*/
+		pool.nthreads++;
+	}/*eo for*/
+
+	return(0);
+
+}/*eo pool_init*/
+
+/*
+** pool_run
+** run fn on every band and wait until all bands are done
+*/
+void pool_run(void (*fn)(void *arg, int band, int nbands), void *arg){
+
+	if(pool.nthreads == 1){
+		fn(arg, 0, 1);
+		return;
+	}/*eo if*/
+
+	pthread_mutex_lock(&pool.lock);
+	pool.fn = fn;
+	pool.arg = arg;
+	pool.pending = pool.nthreads-1;
+	pool.generation++;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+
+	fn(arg, 0, pool.nthreads);
+
+	pthread_mutex_lock(&pool.lock);
+	while(pool.pending)
+		pthread_cond_wait(&pool.done, &pool.lock);
+	pthread_mutex_unlock(&pool.lock);
+
+}/*eo pool_run*/
+
+/*
+** pool_shutdown
+** stop and join the workers
+*/
+void pool_shutdown(void){
+
+	int i=0;
+
+	pthread_mutex_lock(&pool.lock);
+	pool.quit = 1;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+
+	for(i=1; i<pool.nthreads; i++)
+		pthread_join(pool.tid[i], NULL);
+	pool.nthreads = 1;
+
+}/*eo pool_shutdown*/
+
+/*
+** HaarDwt2 job, one band of row pairs per thread
+*/
+struct haar_job {
+	uint16_t *in, *out;
+	int width, height, out_stride;
+};
+
+static void haar_band(void *arg, int band, int nbands){
+
+	struct haar_job *job = arg;
+	int pairs = job->height/2;
+	int first = pairs*band/nbands, last = pairs*(band+1)/nbands;
+	int qrow = (job->height/2)*job->out_stride;
+	uint16_t *r1=NULL, *ll_ptr=NULL;
+	int h=0;
+
+	for(h=first; h<last; h++){
+		r1 = job->in + (2*h)*job->width;
+		ll_ptr = job->out + h*job->out_stride;
+		haar_rows_simd(r1, r1 + job->width, ll_ptr, ll_ptr + job->width/2,
+			       ll_ptr + qrow, ll_ptr + qrow + job->width/2, 
+			       job->width);
+	}/*eo for*/
+
+}/*eo haar_band*/
+
+/*
+** HaarDwt2
+** vectorized, multithreaded HaarDwt of a width x height rgb565 image
+** (both even) into an image with a line length of out_stride pixels.
+** the row pairs are split into one band per pool thread and every band
+** runs the simd kernel picked by init_simd(). the output is byte-identical
+** to HaarDwt().
+*/
+int HaarDwt2(uint16_t *imgin_ptr, uint16_t *imgout_ptr, int width, int height,
+	     int out_stride){
+
+	struct haar_job job;
+
+	job.in = imgin_ptr;
+	job.out = imgout_ptr;
+	job.width = width;
+	job.height = height;
+	job.out_stride = out_stride;
+	pool_run(haar_band, &job);
+
+	return(0);
+
+}/*eo HaarDwt2*/
+
+/*
+** HaarLift2 / HaarUnlift2 job, one band of row pairs of the current
+** level per thread
+*/
+struct lift_job {
+	int16_t *plane;
+	int width, height, stride;
+	int thresh, soft;	/*detail shrinkage, thresh -1 = none*/
+};
+
+static void lift_band(void *arg, int band, int nbands){
+
+	struct lift_job *job = arg;
+	int16_t line[2*MAX_FRAME_WIDTH];
+	int pairs = job->height/2;
+
+	lift_rows(job->plane, job->width, job->stride, pairs*band/nbands, 
+		  pairs*(band+1)/nbands, line, job->thresh, job->soft);
+
+}/*eo lift_band*/
+
+static void unlift_band(void *arg, int band, int nbands){
+
+	struct lift_job *job = arg;
+	int16_t line[2*MAX_FRAME_WIDTH];
+	int pairs = job->height/2;
+
+	unlift_rows(job->plane, job->width, job->stride, pairs*band/nbands, 
+		    pairs*(band+1)/nbands, line);
+
+}/*eo unlift_band*/
+
+/*
+** HaarLift2 / HaarUnlift2
+** multithreaded HaarLift and HaarUnlift. the lifting of every level is
+** split into one band of row pairs per pool thread, the row permutation
+** between the levels is a serial copy. the result is identical to the
+** single thread functions.
+*/
+int HaarLift2(int16_t *plane, int width, int height, int stride, 
+	      int levels){
+
+	int16_t line[MAX_FRAME_WIDTH];
+	struct lift_job job;
+	int n=0, l=0;
+
+	if(width > MAX_FRAME_WIDTH || height > MAX_FRAME_WIDTH)
+		return(-1);
+	n = lift_levels(width, height, levels);
+
+	job.plane = plane;
+	job.stride = stride;
+	job.thresh = -1;
+	job.soft = 0;
+	for(l=0; l<n; l++){
+		job.width = width >> l;
+		job.height = height >> l;
+		pool_run(lift_band, &job);
+		lift_permute_rows(plane, job.width, job.height, stride, line, 0);
+	}/*eo for*/
+
+	return(n);
+
+}/*eo HaarLift2*/
+
+int HaarUnlift2(int16_t *plane, int width, int height, int stride, 
+		int levels){
+
+	int16_t line[MAX_FRAME_WIDTH];
+	struct lift_job job;
+	int n=0, l=0;
+
+	if(width > MAX_FRAME_WIDTH || height > MAX_FRAME_WIDTH)
+		return(-1);
+	n = lift_levels(width, height, levels);
+
+	job.plane = plane;
+	job.stride = stride;
+	for(l=n-1; l>=0; l--){
+		job.width = width >> l;
+		job.height = height >> l;
+		lift_permute_rows(plane, job.width, job.height, stride, line, 1);
+		pool_run(unlift_band, &job);
+	}/*eo for*/
+
+	return(n);
+
+}/*eo HaarUnlift2*/
+
+/*
+** HaarDenoise
+** wavelet shrinkage of an int16 plane: levels of lifting with the detail
+** coefficients thresholded by shrink() as each band makes them, then
+** the inverse. the coefficients are not needed in the quadrant layout, 
+** so the rows are not permuted: the smooth values of a level stay in
+** the left half of the even rows and the next level lifts every other
+** row at twice the stride. thresh 0 gives the plane back unchanged.
+** returns the number of levels.
+*/
+int HaarDenoise(int16_t *plane, int width, int height, int stride, 
+		int levels, int thresh, int soft){
+
+	struct lift_job job;
+	int n=0, l=0;
+
+	if(width > MAX_FRAME_WIDTH || height > MAX_FRAME_WIDTH || thresh < 0 ||
+	   thresh > DENOISE_MAX_THRESH)
+		return(-1);
+	n = lift_levels(width, height, levels);
+
+	job.plane = plane;
+	job.thresh = thresh;
+	job.soft = soft;
+	for(l=0; l<n; l++){
+		job.width = width >> l;
+		job.height = height >> l;
+		job.stride = stride << l;
+		pool_run(lift_band, &job);
+	}/*eo for*/
+	for(l=n-1; l>=0; l--){
+		job.width = width >> l;
+		job.height = height >> l;
+		job.stride = stride << l;
+		pool_run(unlift_band, &job);
+	}/*eo for*/
+
+	return(n);
+
+}/*eo HaarDenoise*/
+
+/*
+** DenoiseRgb565 job, one level of the three planes of a frame. the 
+** first level lifts every row pair straight from its unpacked channels
+** into the planes, the last inverse level packs the rows it unlifted
+** into out, so the full size rows are not copied through line buffers.
+*/
+struct denoise_job {
+	uint16_t *in, *out;
+	int16_t *planes;
+	int width, height;
+	int level;
+	int thresh[3];
+	int mode;
+};
+
+static void denoise_lift_band(void *arg, int band, int nbands){
+
+	struct denoise_job *job = arg;
+	int16_t line[6*MAX_FRAME_WIDTH];	/*row pair of every channel*/
+	const int n = job->width*job->height;
+	const int w = job->width >> job->level;
+	const int stride = job->width << job->level;
+	const int pairs = (job->height >> job->level)/2;
+	int16_t *r1=NULL, *l=NULL;
+	int y=0, c=0;
+
+	for(y=pairs*band/nbands; y<pairs*(band+1)/nbands; y++){
+		r1 = job->planes + 2*y*stride;
+		if(job->level == 0)
+			rgb565_unpack(job->in + 2*y*stride, line, line + 2*w, 
+				      line + 4*w, 2*w);
+		for(c=0; c<3; c++, r1 += n){
+			if(job->level == 0){
+				l = line + 2*c*w;
+				lift_quad_simd(l, l + w, r1, r1 + stride, w, 
+					       job->thresh[c], job->mode);
+				continue;
+			}/*eo if*/
+			lift_quad_simd(r1, r1 + stride, line, line + w, w, 
+				       job->thresh[c], job->mode);
+			memcpy(r1, line, w*sizeof(int16_t));
+			memcpy(r1 + stride, line + w, w*sizeof(int16_t));
+		}/*eo for*/
+	}/*eo for*/
+
+}/*eo denoise_lift_band*/
+
+static void denoise_unlift_band(void *arg, int band, int nbands){
+
+	struct denoise_job *job = arg;
+	int16_t line[6*MAX_FRAME_WIDTH];	/*row pair of every channel*/
+	const int n = job->width*job->height;
+	const int w = job->width >> job->level;
+	const int stride = job->width << job->level;
+	const int pairs = (job->height >> job->level)/2;
+	int16_t *r1=NULL, *l=NULL;
+	int y=0, c=0;
+
+	for(y=pairs*band/nbands; y<pairs*(band+1)/nbands; y++){
+		r1 = job->planes + 2*y*stride;
+		for(c=0; c<3; c++, r1 += n){
+			l = job->level == 0 ? line + 2*c*w : line;
+			unlift_quad_simd(r1, r1 + stride, l, l + w, w);
+			if(job->level == 0)
+				continue;
+			memcpy(r1, line, w*sizeof(int16_t));
+			memcpy(r1 + stride, line + w, w*sizeof(int16_t));
+		}/*eo for*/
+		if(job->level == 0)
+			rgb565_pack(line, line + 2*w, line + 4*w, 
+				    job->out + 2*y*stride, 2*w);
+	}/*eo for*/
+
+}/*eo denoise_unlift_band*/
+
+/*
+** DenoiseRgb565
+** HaarDenoise of the three channels of a width x height rgb565 frame
+** over DENOISE_LEVELS levels into out, planes holds 3*width*height 
+** int16 values. thresh is in steps of the 6 bit middle channel, the 5
+** bit channels use half of it rounded up. all three channels go 
+** through one pool job per level.
+*/
+int DenoiseRgb565(uint16_t *in, uint16_t *out, int16_t *planes, int width,
+		  int height, int thresh, int soft){
+
+	struct denoise_job job;
+	int n=0, l=0;
+
+	if(width > MAX_FRAME_WIDTH || height > MAX_FRAME_WIDTH || thresh < 0 ||
+	   thresh > DENOISE_MAX_THRESH)
+		return(-1);
+	n = lift_levels(width, height, DENOISE_LEVELS);
+
+	/*
+	** a frame that cannot be lifted is shown as it is
+	*/
+	if(n == 0){
+		memcpy(out, in, width*height*sizeof(uint16_t));
+		return(0);
+	}/*eo if*/
+
+	job.in = in;
+	job.out = out;
+	job.planes = planes;
+	job.width = width;
+	job.height = height;
+	job.thresh[0] = job.thresh[2] = (thresh + 1)/2;
+	job.thresh[1] = thresh;
+	job.mode = soft ? SHRINK_SOFT : SHRINK_HARD;
+	for(l=0; l<n; l++){
+		job.level = l;
+		pool_run(denoise_lift_band, &job);
+	}/*eo for*/
+	for(l=n-1; l>=0; l--){
+		job.level = l;
+		pool_run(denoise_unlift_band, &job);
+	}/*eo for*/
+
+	return(0);
+
+}/*eo DenoiseRgb565*/
+
+/*
+** simd_select
+** use the named kernels (scalar, sse2, avx2, neon) for convert5, the
+** haar dwt, the lifting and the scaler if this build and cpu 
+** support them. returns -1 otherwise.
+*/
+int simd_select(char *isa){
+
+	if(strcmp(isa, "scalar") == 0){
+		convert5_pixels = convert4_pixels;
+		haar_rows_simd = haar_rows_scalar;
+		lift_quad_simd = lift_quad_scalar;
+		unlift_quad_simd = unlift_quad_scalar;
+		scale_vblend = scale_vblend_scalar;
+		simd_isa = "scalar";
+		return(0);
+	}/*eo if*/
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if(strcmp(isa, "sse2") == 0 && __builtin_cpu_supports("sse2")){
+		convert5_pixels = convert5_pixels_sse2;
+		haar_rows_simd = haar_rows_sse2;
+		lift_quad_simd = lift_quad_sse2;
+		unlift_quad_simd = unlift_quad_sse2;
+		scale_vblend = scale_vblend_sse2;
+		simd_isa = "sse2";
+		return(0);
+	}/*eo if*/
+	if(strcmp(isa, "avx2") == 0 && __builtin_cpu_supports("avx2")){
+		convert5_pixels = convert5_pixels_avx2;
+		haar_rows_simd = haar_rows_avx2;
+		lift_quad_simd = lift_quad_sse2;
+		unlift_quad_simd = unlift_quad_sse2;
+		scale_vblend = scale_vblend_avx2;
+		simd_isa = "avx2";
+		return(0);
+	}/*eo if*/
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#if defined(__aarch64__)
+	if(strcmp(isa, "neon") == 0){
+#else
+	if(strcmp(isa, "neon") == 0 && (getauxval(AT_HWCAP) & HWCAP_ARM_NEON)){
+#endif
+		convert5_pixels = convert5_pixels_neon;
+		haar_rows_simd = haar_rows_neon;
+		lift_quad_simd = lift_quad_neon;
+		unlift_quad_simd = unlift_quad_neon;
+		scale_vblend = scale_vblend_neon;
+		simd_isa = "neon";
+		return(0);
+	}/*eo if*/
+#endif
+
+	return(-1);
+
+}/*eo simd_select*/
+
+/*
+** init_simd
+** pick the widest simd kernels, SV5_ISA in the environment overrides the
+** choice.
+*/
+int init_simd(void){
+
+	char *isa = getenv("SV5_ISA");
+
+	if(isa){
+		if(simd_select(isa) < 0){
+			fprintf(stderr, "SV5_ISA=%s not supported\n", isa);
+			return(-1);
+		}/*eo if*/
+		return(0);
+	}/*eo if*/
+
+	if(simd_select("avx2") == 0) return(0);
+	if(simd_select("sse2") == 0) return(0);
+	if(simd_select("neon") == 0) return(0);
 
+	return(simd_select("scalar"));
 
+}/*eo init_simd*/
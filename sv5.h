@@ -0,0 +1,343 @@
+/*
+** sv5.h
+** frame geometry, colors and image processing kernels shared by sv5.c
+** and the kernel benchmark bench.c
+*/
+
+#ifndef SV5_H
+#define SV5_H
+
+#include <stdint.h>
+
+/*
+** 4D LCD display resolution 480 x 272
+** HVGA (Half-size VGA) screens have 480×320 pixels (3:2 aspect ratio), 
+** 480×360 pixels (4:3 aspect ratio), 480×272 (~16:9 aspect ratio) 
+** or 640×240 pixels (8:3 aspect ** ratio). 
+*/
+#define	HVGA_WIDTH	480
+#define HVGA_HEIGHT	272 
+#define FRAMEBUF_SIZE	HVGA_WIDTH*HVGA_HEIGHT*2
+/*
+** WQVGA resolution is 432 x 240
+** Logitech c920 USB Camera
+*/
+#define	WQVGA_WIDTH	432
+#define WQVGA_HEIGHT	240
+#define FILEBUF_SIZE	WQVGA_WIDTH*WQVGA_HEIGHT*2
+#define RGB565_SIZE 	WQVGA_WIDTH*WQVGA_HEIGHT*2
+#define RGB888_SIZE 	WQVGA_WIDTH*WQVGA_HEIGHT*3
+#define YUYV_SIZE   	WQVGA_WIDTH*WQVGA_HEIGHT*2
+#define GRAYSCALE_SIZE	WQVGA_WIDTH*WQVGA_HEIGHT
+/*
+** VGA 640 x 480 and HD 1280 x 720 webcam modes
+*/
+#define VGA_WIDTH	640
+#define VGA_HEIGHT	480
+#define HD_WIDTH	1280
+#define HD_HEIGHT	720
+/*
+** widest capture frame the row buffers are sized for
+*/
+#define MAX_FRAME_WIDTH	4096
+/*
+** SVGA resolution is 800 x 600
+*/
+#define SVGA_WIDTH	800
+#define SVGA_HEIGHT	600
+/*
+** WUXGA resolution is 1920 x 1200
+*/
+#define WUXGA_WIDTH	1920
+#define WUXGA_HEIGHT	1200
+/*
+** RGB565
+*/
+#define WHITE	0xffff
+#define YELLOW	0xffe0
+#define CYAN	0x07ff
+#define GREEN	0x07e0
+#define MAGENTA	0xf81f
+#define RED	0xf800
+#define BLUE	0x001f
+#define BLACK	0x0000
+#define GRAY	0xc618
+
+/*
+** frame geometry
+** width and height in pixels, stride is the line length in bytes and
+** pixfmt the v4l2 fourcc of the pixels
+*/
+struct geometry {
+	int width;
+	int height;
+	int stride;
+	uint32_t pixfmt;
+};
+
+extern struct geometry cap_geo;	/*webcam, VIDIOC_S_FMT/G_FMT*/
+extern struct geometry fb_geo;	/*framebuffer, FBIOGET_*SCREENINFO*/
+
+/*
+** rectangle of the visible framebuffer area
+*/
+struct region {
+	int x, y;
+	int width, height;
+};
+
+/*
+** compact yuv422 to rgb565 tables
+** ITU-R 601 contributions of Y, U and V in 16.16 fixed point plus a
+** clamp table indexed by the integer part of the sum
+*/
+#define TAB_CLAMP_MIN	-288
+#define TAB_CLAMP_SIZE	832
+
+/*
+** yuv2rgb.lut file written by lut.c
+** a header padded to LUT_OFFSET bytes, then the table of LUT_ENTRIES
+** pixels indexed by Y<<16 | U<<8 | V
+*/
+#define LUT_MAGIC	"yuv2rgb"
+#define LUT_VERSION	1
+#define LUT_OFFSET	4096
+#define LUT_ENTRIES	(256*256*256)
+
+enum { LUT_BT601 = 1 };			/*colorspace*/
+enum { LUT_RGB565 = 0, LUT_BGR565 = 1 };	/*pixel order*/
+
+struct lut_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t colorspace;
+	uint32_t order;
+	uint32_t entries;
+	uint64_t checksum;
+};
+
+/*
+** lut_checksum
+** fletcher style sums over the 32 bit words of the table, the running
+** sum in the low half and the sum of sums in the high half
+*/
+static inline uint64_t lut_checksum(const uint16_t *table, long entries){
+
+	const uint32_t *w = (const uint32_t *)table;
+	uint32_t sum1=0, sum2=0;
+	long i=0;
+
+	for(i=0; i<entries/2; i++){
+		sum1 += w[i];
+		sum2 += sum1;
+	}/*eo for*/
+
+	return(((uint64_t)sum2 << 32) | sum1);
+
+}/*eo lut_checksum*/
+
+/*
+** end-to-end latency budget of a frame, capture to display
+*/
+#define LATENCY_BUDGET_MS	100
+
+/*
+** latency histogram, log-linear microsecond buckets: one per value 
+** below 2^LAT_SUB_BITS, then 2^LAT_SUB_BITS per power of 2 (< 3.2% 
+** error) up to 2^32
+*/
+#define LAT_SUB_BITS	5
+#define LAT_BUCKETS	((33-LAT_SUB_BITS)<<LAT_SUB_BITS)
+struct latency_hist {
+	char *name;
+	long count;
+	uint32_t max_us;
+	uint32_t bucket[LAT_BUCKETS];
+};
+int lat_bucket(uint32_t us);
+uint32_t lat_bucket_max(int bucket);
+void lat_add(struct latency_hist *h, int64_t ns);
+
+/*
+** function declarations
+*/
+uint16_t rgb888_to_rgb565(uint32_t);
+uint32_t yuv422_to_rgb888(uint8_t Y, uint8_t U, uint8_t V);
+uint16_t yuv422_to_rgb565(uint8_t Y, uint8_t U, uint8_t V);
+int display_HDMI(void *fbp, uint8_t *rgb565ptr);
+int display_LCD4(void *fbp, void *filebuf);
+int convert2(void *cbp, uint8_t *rgb565ptr);
+int convert3(void *cbp, uint8_t *rgb565ptr, uint16_t *pbuf);
+int RGBColorBars_HDMI(void *fbp);
+int RGBColorBars_LCD4(void *fbp);
+int RGBDisplayFile_HDMI(void *fbp, char *filepath);
+int ReadRGBFile(void *filebuf, char *fpath);
+int WriteRGBFile(void *filebuf, char *fpath);
+int init_fb_color(void *fbp, uint16_t color);
+int clear_fb_page(void *fbp, uint16_t color);
+int convert4(void *cbp, uint8_t *rgb565ptr);
+void convert4_pixels(uint8_t *yuvptr, uint16_t *outptr, int npixels);
+int init_simd(void);
+int simd_select(char *isa);
+int convert5(void *cbp, uint8_t *rgb565ptr);
+extern char *simd_isa;
+extern void (*convert5_pixels)(uint8_t *yuvptr, uint16_t *outptr, int npixels);
+
+/*
+** haar dwt constants and function declaration
+*/
+int HaarDwt(uint16_t *imgin_ptr, uint16_t *imgout_ptr);
+int HaarDwtYuyv(void *cbp, uint16_t *imgout_ptr);
+int HaarDwtStride(uint16_t *imgin_ptr, uint16_t *imgout_ptr, int out_stride);
+int HaarDwtYuyvStride(void *cbp, uint16_t *imgout_ptr, int out_stride);
+int HaarDwt2(uint16_t *imgin_ptr, uint16_t *imgout_ptr, int width, int height,
+	     int out_stride);
+
+/*
+** luma only path, 8 bit frames
+*/
+int LumaExtract(void *cbp, uint8_t *grayptr);
+int HaarDwtGray(uint8_t *imgin_ptr, uint8_t *imgout_ptr);
+int display_gray(void *fbp, uint8_t *gray);
+
+/*
+** fixed point scaler into the framebuffer, 5 bit bilinear weights
+*/
+enum { SCALE_NEAREST = 1, SCALE_BILINEAR = 2 };
+#define SCALE_FRAC	5
+#define SCALE_ONE	(1 << SCALE_FRAC)
+struct scaler {
+	int mode;
+	int src_width, src_height;
+	int width, height;		/*scaled frame*/
+	int32_t *xi, *yi;		/*source column, row*/
+	uint8_t *xw, *yw;		/*weight of the next one*/
+};
+extern void (*scale_vblend)(uint16_t *dst, const uint16_t *r0, 
+			    const uint16_t *r1, int w, int npixels);
+int scale_init(struct scaler *s, int mode, int src_width, int src_height,
+	       int width, int height);
+void scale_free(struct scaler *s);
+int scale_rgb565(struct scaler *s, void *fbp, const struct region *r, 
+		 const void *src, int src_stride);
+void scale_fit(int src_width, int src_height, int *width, int *height);
+
+/*
+** multi-view compositor, one or two views of a cap_geo frame in regions
+** of the framebuffer. band is the dwt subband 0..3 (ll, lh, hl, hh) of
+** a zoomed view, -1 for the whole frame.
+*/
+enum { VIEW_DWT, VIEW_RAW, VIEW_SPLIT, VIEW_ZOOM, NVIEW_LAYOUTS };
+enum { VIEW_SRC_RAW, VIEW_SRC_DWT };
+struct view {
+	int src;
+	int band;
+	struct region r;
+	int scaled;
+	struct scaler s;
+};
+struct compositor {
+	int layout, band;
+	int nviews;
+	struct view v[2];
+};
+extern char *view_layouts[NVIEW_LAYOUTS];
+extern char *view_bands[4];
+int compose_layout(struct compositor *c, int layout, int band, int mode,
+		   int stretch);
+int compose(struct compositor *c, void *fbp, const uint16_t *raw, 
+	    const uint16_t *dwt);
+void compose_free(struct compositor *c);
+
+/*
+** telemetry overlay, text cells drawn into the framebuffer within a
+** microsecond budget per frame
+*/
+#define OSD_LINES	2
+#define OSD_COLS	40
+#define OSD_BUDGET_US	200
+const uint8_t *osd_glyph(int c);
+int osd_zoom(void);
+int osd_top(void);
+void osd_printf(int line, const char *fmt, ...);
+void osd_damage(int y, int height);
+void osd_invalidate(void);
+int osd_draw(void *fbp, int budget_us);
+
+/*
+** multi-level integer haar lifting on planar int16 frames
+*/
+#define LIFT_MAX_LEVELS	8
+int lift_levels(int width, int height, int levels);
+int HaarLift(int16_t *plane, int width, int height, int stride, int levels);
+int HaarUnlift(int16_t *plane, int width, int height, int stride, 
+	       int levels);
+int HaarLift2(int16_t *plane, int width, int height, int stride, 
+	      int levels);
+int HaarUnlift2(int16_t *plane, int width, int height, int stride, 
+		int levels);
+int Rgb565ToPlanes(uint16_t *rgb565ptr, int16_t *planes, int width, 
+		   int height);
+int PlanesToRgb565(int16_t *planes, uint16_t *rgb565ptr, int width, 
+		   int height);
+
+/*
+** wavelet denoise, thresholded lifting and its inverse
+*/
+#define DENOISE_LEVELS	3
+#define DENOISE_MAX_THRESH	1023
+int HaarDenoise(int16_t *plane, int width, int height, int stride, 
+		int levels, int thresh, int soft);
+int DenoiseRgb565(uint16_t *in, uint16_t *out, int16_t *planes, int width,
+		  int height, int thresh, int soft);
+
+/*
+** persistent worker pool
+*/
+int pool_init(int nthreads);
+void pool_run(void (*fn)(void *arg, int band, int nbands), void *arg);
+void pool_shutdown(void);
+
+/*
+** hardware performance counters, -1 where not available
+*/
+enum {
+	PERF_CYCLES, PERF_INSTRUCTIONS, PERF_CACHE_MISSES, PERF_DTLB_MISSES, 
+	NPERF
+};
+extern char *perf_name[NPERF];
+int perf_open(void);
+void perf_start(void);
+void perf_stop(long long *val);
+void perf_close(void);
+
+/*
+** framebuffer
+*/
+uint16_t *fb_origin(void *fbp, int width, int height);
+int fb_geometry(void);
+int fb_open_device(char *path);
+int fb_open_file(char *spec);
+int fb_flip(void);
+
+/*
+** row blit engine, the part of an image that shows in the framebuffer:
+** first source column and row, size and first framebuffer pixel
+*/
+struct blit_area {
+	uint16_t *dst;
+	int sx, sy;
+	int y;				/*first row in the visible area*/
+	int width, height;
+};
+extern char *blit_mode;
+extern void (*blit_row)(uint16_t *dst, const uint16_t *src, int npixels);
+int blit_select(char *mode);
+int init_blit(void);
+void blit_flush(void);
+int blit_clip(void *fbp, const struct region *r, int width, int height, 
+	      struct blit_area *a);
+int blit_rgb565(void *fbp, const struct region *r, const void *src, 
+		int width, int height, int src_stride);
+
+#endif /*SV5_H*/